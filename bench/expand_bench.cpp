@@ -0,0 +1,106 @@
+// Compares the SIMD level expansion kernels against the original recursive push_back
+// generator from FirstApp, at depths 13 to 16. Reports triangles/s: the recursion writes LveModel::Vertex
+// (60 bytes per triangle) and the kernels SoA corners (24 bytes), so bytes/s wouldn't compare the same work.
+// The kernels' times leave out the conversion to LveModel::Vertex (SierpinskiGenerator::generateExpanded
+// does it while expanding), so the speedup is that of the expansion alone.
+// usage: expand_bench [minDepth] [maxDepth]
+
+#include "lve_model.hpp"
+#include "sierpinski_expand.hpp"
+#include "sierpinski_generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// FirstApp::sierpinski as it used to be: one recursive call per triangle, glm::vec2 math and push_back
+void sierpinskiRecursive(
+    std::vector<std::vector<lve::LveModel::Vertex>> &vertices,
+    int level,
+    glm::vec2 left,
+    glm::vec2 right,
+    glm::vec2 top) {
+    vertices[level].push_back({top});
+    vertices[level].push_back({right});
+    vertices[level].push_back({left});
+    if (level + 1 < static_cast<int>(vertices.size())) {
+        auto topleft = 0.5f * (top + left);
+        auto topright = 0.5f * (top + right);
+        auto rightleft = 0.5f * (right + left);
+        sierpinskiRecursive(vertices, level + 1, topleft, left, rightleft);
+        sierpinskiRecursive(vertices, level + 1, topright, rightleft, right);
+        sierpinskiRecursive(vertices, level + 1, top, topleft, topright);
+    }
+}
+
+template <typename F>
+double bestOf(int runs, F &&function) {
+    double best = 1e30;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+void report(const char *name, int depth, double seconds, uint64_t triangles, double baselineSeconds) {
+    std::cout << std::setw(12) << name << std::setw(8) << depth
+              << std::setw(12) << std::fixed << std::setprecision(2) << seconds * 1000.0
+              << std::setw(14) << std::setprecision(1) << static_cast<double>(triangles) / seconds / 1e6
+              << std::setw(12) << std::setprecision(2) << baselineSeconds / seconds << "\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int minDepth = 13;
+    int maxDepth = 16;
+    if (argc > 1) minDepth = std::atoi(argv[1]);
+    if (argc > 2) maxDepth = std::atoi(argv[2]);
+
+    std::cout << std::setw(12) << "kernel" << std::setw(8) << "depth" << std::setw(12) << "best ms"
+              << std::setw(14) << "Mtriangles/s" << std::setw(12) << "speedup" << "\n";
+
+    for (int depth = minDepth; depth <= maxDepth; depth++) {
+        // levels 0 .. depth - 1 like FirstApp::maxDepth, level 0 is given so depth - 1 levels are produced
+        uint64_t triangles = (lve::SierpinskiGenerator::triangleCount(depth) - 1) / 2;
+        int runs = depth >= 15 ? 1 : 3;
+
+        double recursive = bestOf(runs, [&] {
+            std::vector<std::vector<lve::LveModel::Vertex>> vertices(depth);
+            sierpinskiRecursive(vertices, 0, {-1.f, 1.f}, {1.f, 1.f}, {0.0f, -1.f});
+        });
+        report("recursive", depth, recursive, triangles, recursive);
+
+        for (auto kernel : {lve::SierpinskiExpander::Kernel::Scalar, lve::SierpinskiExpander::Kernel::SSE,
+                            lve::SierpinskiExpander::Kernel::AVX2, lve::SierpinskiExpander::Kernel::NEON}) {
+            if (!lve::SierpinskiExpander::isSupported(kernel)) {
+                continue;
+            }
+            lve::SierpinskiExpander expander{kernel};
+            double seconds = bestOf(runs, [&] {
+                std::vector<lve::SierpinskiSoA> levels(depth);
+                levels[0].resize(1);
+                levels[0].topX[0] = 0.0f;
+                levels[0].topY[0] = -1.0f;
+                levels[0].rightX[0] = 1.0f;
+                levels[0].rightY[0] = 1.0f;
+                levels[0].leftX[0] = -1.0f;
+                levels[0].leftY[0] = 1.0f;
+                for (int level = 1; level < depth; level++) {
+                    levels[level].resize(3 * levels[level - 1].size());
+                    expander.expand(levels[level - 1], levels[level]);
+                }
+            });
+            report(lve::SierpinskiExpander::kernelName(kernel), depth, seconds, triangles, recursive);
+        }
+    }
+    return EXIT_SUCCESS;
+}
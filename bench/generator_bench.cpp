@@ -0,0 +1,53 @@
+// Measures SierpinskiGenerator throughput for every thread count from 1 to the number of
+// hardware threads and for depths 8 to 16.
+// usage: generator_bench [maxThreads] [minDepth] [maxDepth]
+
+#include "lve_thread_pool.hpp"
+#include "sierpinski_generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+int main(int argc, char **argv) {
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    int minDepth = 8;
+    int maxDepth = 16;
+    if (argc > 1) maxThreads = static_cast<unsigned>(std::atoi(argv[1]));
+    if (argc > 2) minDepth = std::atoi(argv[2]);
+    if (argc > 3) maxDepth = std::atoi(argv[3]);
+
+    std::cout << std::setw(8) << "threads" << std::setw(8) << "depth" << std::setw(14) << "triangles"
+              << std::setw(12) << "best ms" << std::setw(18) << "triangles/s" << std::setw(10) << "speedup" << "\n";
+
+    for (int depth = minDepth; depth <= maxDepth; depth++) {
+        // levels 0 .. depth - 1, the same meaning FirstApp::maxDepth has
+        uint64_t triangles = (lve::SierpinskiGenerator::triangleCount(depth) - 1) / 2;
+        double singleThreadSeconds = 0.0;
+        for (unsigned threads = 1; threads <= maxThreads; threads++) {
+            lve::LveThreadPool pool{threads};
+            lve::SierpinskiGenerator generator{pool};
+
+            double best = 1e30;
+            int runs = depth >= 15 ? 1 : 3;
+            for (int run = 0; run < runs; run++) {
+                auto start = std::chrono::steady_clock::now();
+                auto levels = generator.generate(depth);
+                auto end = std::chrono::steady_clock::now();
+                best = std::min(best, std::chrono::duration<double>(end - start).count());
+            }
+            if (threads == 1) {
+                singleThreadSeconds = best;
+            }
+
+            std::cout << std::setw(8) << threads << std::setw(8) << depth << std::setw(14) << triangles
+                      << std::setw(12) << std::fixed << std::setprecision(2) << best * 1000.0
+                      << std::setw(18) << std::setprecision(0) << triangles / best
+                      << std::setw(10) << std::setprecision(2) << singleThreadSeconds / best << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
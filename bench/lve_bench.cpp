@@ -0,0 +1,682 @@
+// Fixed benchmark scenarios for catching performance regressions, runs without a window or a
+// display (lavapipe is fine):
+//   generate/depth=N      cpu generation of levels 0 .. N - 1 (generateExpanded on the thread pool)
+//   upload/depth=N        copying those levels into device local vertex buffers through LveUploader
+//   render/<mode>         steady state headless rendering at 800x600, every level drawn every frame
+//                         (vertices-packed16/32: the vertices mode with fixed point vertex buffers,
+//                         vertices-indexed: unique corners plus an index buffer,
+//                         vertices-arena: every level a range of one LveMeshArena)
+//   render/culled         the same levels walked and culled on the gpu by CulledRenderSystem, nothing
+//                         generated; render/culled-depth=24 goes as deep as it can, the frame time
+//                         should barely move
+//   record/inline         cpu time to record --record-objects small procedural draws on one thread
+//   record/threads=N      the same recorded into N secondary command buffers on N threads
+//   record/indirect       the same objects drawn from a mesh arena by IndirectRenderSystem
+//   recreate/offscreen    destroying and creating the render target (what a resize costs)
+// Every scenario reports median / p95 / p99 milliseconds, peak memory and where it makes sense
+// triangles/s, written as JSON. With --baseline the results are compared against an earlier JSON
+// file and the exit code is 1 when a metric got worse by more than --threshold percent. p95 and p99
+// are only compared for scenarios with at least MIN_TAIL_SAMPLES samples, with fewer they are one
+// or two outliers and the median is the only stable timing.
+// usage: lve_bench [--json=out.json] [--baseline=baseline.json] [--threshold=10] [--frames=500]
+//                  [--min-depth=8] [--max-depth=16] [--upload-depth=13] [--render-depth=12] [--runs=5]
+//                  [--record-objects=20000]
+
+#include "culled_render_system.hpp"
+#include "indirect_render_system.hpp"
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "lve_mesh_arena.hpp"
+#include "lve_model.hpp"
+#include "lve_offscreen_target.hpp"
+#include "lve_parallel_recorder.hpp"
+#include "lve_renderer.hpp"
+#include "lve_thread_pool.hpp"
+#include "lve_uploader.hpp"
+#include "sierpinski_generator.hpp"
+#include "simple_render_system.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr VkExtent2D RENDER_EXTENT{800, 600};
+// frames rendered before measuring, until then pipelines, caches and clocks are still warming up
+constexpr int WARMUP_FRAMES = 30;
+
+struct Options {
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10.0;
+    int frames = 500;
+    int minDepth = 8;
+    int maxDepth = 16;
+    int uploadDepth = 13;
+    int renderDepth = 12;
+    int runs = 5;
+    int recordObjects = 20000;
+};
+
+struct Result {
+    std::string name;
+    // metric -> value, "*_ms" and "*_bytes" are better when lower, "*_per_s" when higher
+    std::map<std::string, double> metrics;
+    // timing samples behind the percentiles, not written to the JSON
+    size_t samples = 0;
+};
+
+// fewer samples than this leave p95 / p99 out of the baseline comparison
+constexpr size_t MIN_TAIL_SAMPLES = 100;
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// nearest rank, like LveGpuProfiler
+double percentile(std::vector<double> samples, double p) {
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+    return samples[std::max<size_t>(rank, 1) - 1];
+}
+
+uint64_t peakResidentBytes() {
+#ifdef _WIN32
+    return 0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+Result timingResult(const std::string &name, const std::vector<double> &ms) {
+    Result result{name, {}, ms.size()};
+    result.metrics["median_ms"] = percentile(ms, 0.5);
+    result.metrics["p95_ms"] = percentile(ms, 0.95);
+    result.metrics["p99_ms"] = percentile(ms, 0.99);
+    // high water mark of the whole process so far, scenarios run from small to large
+    result.metrics["peak_rss_bytes"] = static_cast<double>(peakResidentBytes());
+    return result;
+}
+
+// triangles in levels 0 .. levelCount - 1
+uint64_t triangleCount(int levelCount) {
+    return (lve::SierpinskiGenerator::triangleCount(levelCount) - 1) / 2;
+}
+
+void benchGeneration(const Options &options, std::vector<Result> &results) {
+    lve::LveThreadPool pool{};
+    lve::SierpinskiGenerator generator{pool};
+    for (int depth = options.minDepth; depth <= options.maxDepth; depth++) {
+        // the deep levels take long, but a single run would make the median a single sample
+        int runs = depth >= 15 ? std::min(options.runs, 3) : options.runs;
+        std::vector<double> ms;
+        for (int run = 0; run < runs; run++) {
+            auto start = Clock::now();
+            auto levels = generator.generateExpanded(depth);
+            ms.push_back(elapsedMs(start));
+        }
+        Result result = timingResult("generate/depth=" + std::to_string(depth), ms);
+        result.metrics["triangles_per_s"] = triangleCount(depth) / (result.metrics["median_ms"] * 1e-3);
+        results.push_back(std::move(result));
+    }
+}
+
+void benchUpload(lve::LveDevice &device, const Options &options, std::vector<Result> &results) {
+    lve::LveThreadPool pool{};
+    lve::SierpinskiGenerator generator{pool};
+    auto levels = generator.generateExpanded(options.uploadDepth);
+
+    std::vector<double> ms;
+    device.allocator().resetPeak();
+    for (int run = 0; run < options.runs; run++) {
+        auto start = Clock::now();
+        std::vector<std::shared_ptr<lve::LveModel>> models;
+        {
+            lve::LveUploader uploader{device};
+            for (auto &level : levels) {
+                models.push_back(std::make_shared<lve::LveModel>(device, uploader, level));
+            }
+            uploader.flush();
+        }
+        ms.push_back(elapsedMs(start));
+    }
+    Result result = timingResult("upload/depth=" + std::to_string(options.uploadDepth), ms);
+    result.metrics["peak_gpu_bytes"] = static_cast<double>(device.allocator().stats().peakReservedBytes);
+    result.metrics["triangles_per_s"] = triangleCount(options.uploadDepth) / (result.metrics["median_ms"] * 1e-3);
+    results.push_back(std::move(result));
+}
+
+// how the vertices mode stores its levels
+struct VertexSetup {
+    lve::VertexFormat vertexFormat = lve::VertexFormat::Float;
+    bool indexed = false;
+    // one LveMeshArena for all levels instead of an LveModel per level
+    bool arena = false;
+};
+
+void benchRender(
+    lve::LveDevice &device, const Options &options, lve::RenderMode mode, const char *modeName,
+    std::vector<Result> &results, const VertexSetup &setup = {}) {
+    // the peak includes the staging memory of the upload
+    device.allocator().resetPeak();
+    std::vector<lve::LveGameObject> gameObjects;
+    {
+        const bool indexed = setup.indexed;
+        const lve::VertexFormat vertexFormat = setup.vertexFormat;
+        std::vector<std::vector<lve::LveModel::Vertex>> levels;
+        std::vector<lve::SierpinskiGenerator::IndexedLevel> indexedLevels;
+        lve::LveThreadPool pool{};
+        if (mode == lve::RenderMode::Vertices) {
+            lve::SierpinskiGenerator generator{pool};
+            if (indexed) {
+                indexedLevels = generator.generateIndexed(options.renderDepth);
+            } else {
+                levels = generator.generateExpanded(options.renderDepth);
+            }
+        }
+        lve::LveUploader uploader{device};
+        std::shared_ptr<lve::LveMeshArena> arena;
+        if (mode == lve::RenderMode::Vertices && setup.arena) {
+            arena = std::make_shared<lve::LveMeshArena>(device, vertexFormat);
+        }
+        for (int depth = 0; depth < options.renderDepth; depth++) {
+            auto object = lve::LveGameObject::createGameObject();
+            if (arena) {
+                object.meshArena = arena;
+                object.mesh = indexed ? arena->add(indexedLevels[depth].vertices, indexedLevels[depth].indices)
+                                      : arena->add(levels[depth]);
+            } else if (mode == lve::RenderMode::Vertices && indexed) {
+                object.model = std::make_shared<lve::LveModel>(
+                    device, uploader, indexedLevels[depth].vertices, indexedLevels[depth].indices, vertexFormat);
+            } else if (mode == lve::RenderMode::Vertices) {
+                object.model = std::make_shared<lve::LveModel>(device, uploader, levels[depth], vertexFormat);
+            }
+            object.color = {0.1f, 0.8f, 0.1f};
+            object.depth = depth;
+            gameObjects.push_back(std::move(object));
+        }
+        if (arena) {
+            arena->upload(uploader);
+        }
+        uploader.flush();
+    }
+
+    lve::LveRenderer renderer{device, RENDER_EXTENT};
+    lve::SimpleRenderSystem renderSystem{
+        device, renderer.getSwapChainRenderPass(), mode, options.renderDepth, nullptr, setup.vertexFormat};
+    std::vector<double> ms;
+    for (int frame = 0; frame < WARMUP_FRAMES + options.frames; frame++) {
+        if (frame == WARMUP_FRAMES) {
+            renderer.getGpuProfiler().reset();
+        }
+        // with frames in flight the loop runs at the gpu's pace once the fences start blocking
+        auto start = Clock::now();
+        if (auto commandBuffer = renderer.beginFrame()) {
+            renderer.beginSwapChainRenderPass(commandBuffer);
+            renderSystem.renderGameObjects(commandBuffer, gameObjects, &renderer.getGpuProfiler());
+            renderer.endSwapChainRenderPass(commandBuffer);
+            renderer.endFrame();
+        }
+        if (frame >= WARMUP_FRAMES) {
+            ms.push_back(elapsedMs(start));
+        }
+    }
+    vkDeviceWaitIdle(device.device());
+
+    Result result = timingResult(std::string("render/") + modeName, ms);
+    result.metrics["peak_gpu_bytes"] = static_cast<double>(device.allocator().stats().peakReservedBytes);
+    result.metrics["triangles_per_s"] = triangleCount(options.renderDepth) / (result.metrics["median_ms"] * 1e-3);
+    for (const auto &scope : renderer.getGpuProfiler().stats()) {
+        if (scope.name == "render pass") {
+            result.metrics["gpu_avg_ms"] = scope.avgMs;
+        }
+    }
+    results.push_back(std::move(result));
+}
+
+void benchCulled(lve::LveDevice &device, const Options &options, int depth, std::vector<Result> &results) {
+    device.allocator().resetPeak();
+    std::vector<lve::LveGameObject> gameObjects;
+    for (int level = 0; level < depth; level++) {
+        auto object = lve::LveGameObject::createGameObject();
+        object.color = {0.1f, 0.8f, 0.1f};
+        object.depth = level;
+        gameObjects.push_back(std::move(object));
+    }
+
+    lve::LveRenderer renderer{device, RENDER_EXTENT};
+    lve::CulledRenderSystem renderSystem{
+        device, renderer.getSwapChainRenderPass(), renderer.getFramesInFlight(), RENDER_EXTENT};
+    std::vector<double> ms;
+    for (int frame = 0; frame < WARMUP_FRAMES + options.frames; frame++) {
+        if (frame == WARMUP_FRAMES) {
+            renderer.getGpuProfiler().reset();
+        }
+        auto start = Clock::now();
+        if (auto commandBuffer = renderer.beginFrame()) {
+            renderSystem.cull(
+                commandBuffer, renderer.getFrameIndex(), gameObjects, RENDER_EXTENT, &renderer.getGpuProfiler());
+            renderer.beginSwapChainRenderPass(commandBuffer);
+            renderSystem.renderGameObjects(commandBuffer, renderer.getFrameIndex(), gameObjects);
+            renderer.endSwapChainRenderPass(commandBuffer);
+            renderer.endFrame();
+        }
+        if (frame >= WARMUP_FRAMES) {
+            ms.push_back(elapsedMs(start));
+        }
+    }
+    vkDeviceWaitIdle(device.device());
+
+    bool deepest = depth > options.renderDepth;
+    Result result = timingResult(deepest ? "render/culled-depth=" + std::to_string(depth) : "render/culled", ms);
+    result.metrics["peak_gpu_bytes"] = static_cast<double>(device.allocator().stats().peakReservedBytes);
+    // triangles the levels would have, not the ones drawn
+    result.metrics["triangles_per_s"] = triangleCount(depth) / (result.metrics["median_ms"] * 1e-3);
+    for (const auto &scope : renderer.getGpuProfiler().stats()) {
+        if (scope.name == "render pass") {
+            result.metrics["gpu_avg_ms"] = scope.avgMs;
+        } else if (scope.name == "cull") {
+            result.metrics["gpu_cull_avg_ms"] = scope.avgMs;
+        }
+    }
+    std::cerr << "render: culled depth " << depth << " " << std::fixed << std::setprecision(2)
+              << result.metrics["median_ms"] << " ms" << std::endl;
+    results.push_back(std::move(result));
+}
+
+void benchRecording(lve::LveDevice &device, const Options &options, std::vector<Result> &results) {
+    // many tiny draws, so the cpu side dominates: the gpu work per frame is a few triangles per object
+    constexpr int OBJECT_DEPTH = 2;
+    std::vector<lve::LveGameObject> gameObjects;
+    for (int i = 0; i < options.recordObjects; i++) {
+        auto object = lve::LveGameObject::createGameObject();
+        float x = static_cast<float>(i % 200) / 100.0f - 1.0f;
+        float y = static_cast<float>(i / 200 % 200) / 100.0f - 1.0f;
+        object.transform2d.translation = {x, y};
+        object.transform2d.scale = {0.01f, 0.01f};
+        object.color = {0.1f, 0.8f, 0.1f};
+        object.depth = OBJECT_DEPTH;
+        gameObjects.push_back(std::move(object));
+    }
+
+    lve::LveRenderer renderer{device, RENDER_EXTENT};
+    lve::SimpleRenderSystem renderSystem{
+        device, renderer.getSwapChainRenderPass(), lve::RenderMode::Procedural, OBJECT_DEPTH + 1};
+
+    // threads = 0 records inline on the primary command buffer
+    auto run = [&](unsigned threads) {
+        std::unique_ptr<lve::LveThreadPool> pool;
+        std::unique_ptr<lve::LveParallelRecorder> recorder;
+        if (threads > 0) {
+            pool = std::make_unique<lve::LveThreadPool>(threads);
+            recorder = std::make_unique<lve::LveParallelRecorder>(device, *pool, renderer.getFramesInFlight());
+        }
+        std::vector<double> ms;
+        for (int frame = 0; frame < WARMUP_FRAMES + options.frames; frame++) {
+            if (auto commandBuffer = renderer.beginFrame()) {
+                // only the recording is timed, the fence waits in beginFrame don't depend on the thread count
+                auto start = Clock::now();
+                if (recorder) {
+                    renderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    renderSystem.renderGameObjects(commandBuffer, gameObjects, renderer, *recorder);
+                } else {
+                    renderer.beginSwapChainRenderPass(commandBuffer);
+                    renderSystem.renderGameObjects(commandBuffer, gameObjects);
+                }
+                renderer.endSwapChainRenderPass(commandBuffer);
+                if (frame >= WARMUP_FRAMES) {
+                    ms.push_back(elapsedMs(start));
+                }
+                renderer.endFrame();
+            }
+        }
+        // the recorder's command buffers may still be executing
+        vkDeviceWaitIdle(device.device());
+
+        Result result = timingResult(threads > 0 ? "record/threads=" + std::to_string(threads) : "record/inline", ms);
+        result.metrics["draws_per_s"] = gameObjects.size() / (result.metrics["median_ms"] * 1e-3);
+        return result;
+    };
+
+    Result inlineResult = run(0);
+    double inlineMs = inlineResult.metrics["median_ms"];
+    results.push_back(std::move(inlineResult));
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        Result result = run(threads);
+        std::cerr << "record: " << threads << " threads " << std::fixed << std::setprecision(2)
+                  << result.metrics["median_ms"] << " ms, " << inlineMs / result.metrics["median_ms"]
+                  << "x inline" << std::endl;
+        results.push_back(std::move(result));
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+}
+
+void benchIndirect(lve::LveDevice &device, const Options &options, std::vector<Result> &results) {
+    // same objects as benchRecording, all sharing one small level in a mesh arena
+    constexpr int OBJECT_DEPTH = 2;
+    auto arena = std::make_shared<lve::LveMeshArena>(device);
+    lve::LveMeshRange mesh;
+    {
+        lve::LveThreadPool pool{};
+        lve::SierpinskiGenerator generator{pool};
+        auto levels = generator.generate(OBJECT_DEPTH + 1);
+        mesh = arena->add(levels[OBJECT_DEPTH]);
+        lve::LveUploader uploader{device};
+        arena->upload(uploader);
+        uploader.flush();
+    }
+    std::vector<lve::LveGameObject> gameObjects;
+    for (int i = 0; i < options.recordObjects; i++) {
+        auto object = lve::LveGameObject::createGameObject();
+        float x = static_cast<float>(i % 200) / 100.0f - 1.0f;
+        float y = static_cast<float>(i / 200 % 200) / 100.0f - 1.0f;
+        object.transform2d.translation = {x, y};
+        object.transform2d.scale = {0.01f, 0.01f};
+        object.color = {0.1f, 0.8f, 0.1f};
+        object.depth = OBJECT_DEPTH;
+        object.meshArena = arena;
+        object.mesh = mesh;
+        gameObjects.push_back(std::move(object));
+    }
+
+    lve::LveRenderer renderer{device, RENDER_EXTENT};
+    lve::IndirectRenderSystem renderSystem{device, renderer.getSwapChainRenderPass(), renderer.getFramesInFlight()};
+    std::vector<double> ms;
+    for (int frame = 0; frame < WARMUP_FRAMES + options.frames; frame++) {
+        if (auto commandBuffer = renderer.beginFrame()) {
+            // includes writing the object data and the commands, that part still grows with the objects
+            auto start = Clock::now();
+            renderer.beginSwapChainRenderPass(commandBuffer);
+            renderSystem.renderGameObjects(commandBuffer, renderer.getFrameIndex(), gameObjects);
+            renderer.endSwapChainRenderPass(commandBuffer);
+            if (frame >= WARMUP_FRAMES) {
+                ms.push_back(elapsedMs(start));
+            }
+            renderer.endFrame();
+        }
+    }
+    vkDeviceWaitIdle(device.device());
+
+    Result result = timingResult("record/indirect", ms);
+    result.metrics["draws_per_s"] = gameObjects.size() / (result.metrics["median_ms"] * 1e-3);
+    std::cerr << "record: indirect" << (renderSystem.usesMultiDraw() ? "" : " (one call per object)") << " "
+              << std::fixed << std::setprecision(2) << result.metrics["median_ms"] << " ms" << std::endl;
+    results.push_back(std::move(result));
+}
+
+void benchRecreate(lve::LveDevice &device, const Options &options, std::vector<Result> &results) {
+    // Without a surface there is no swap chain, the offscreen target is recreated instead: the same
+    // image, view, render pass and framebuffer work minus the presentation engine.
+    std::vector<double> ms;
+    for (int run = 0; run < 4 * options.runs; run++) {
+        auto start = Clock::now();
+        auto target = std::make_unique<lve::LveOffscreenTarget>(device, RENDER_EXTENT);
+        target->waitForFrames();
+        target.reset();
+        ms.push_back(elapsedMs(start));
+    }
+    results.push_back(timingResult("recreate/offscreen", ms));
+}
+
+void writeJson(std::ostream &out, const std::vector<Result> &results) {
+    out << std::setprecision(9);
+    out << "{\n  \"version\": 1,\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        out << "    {\"name\": \"" << results[i].name << "\"";
+        for (const auto &metric : results[i].metrics) {
+            out << ", \"" << metric.first << "\": " << metric.second;
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// reads back what writeJson wrote: an array of flat objects with string and number values
+class JsonReader {
+public:
+    explicit JsonReader(std::string text) : text{std::move(text)} {}
+
+    std::vector<Result> readResults() {
+        size_t key = text.find("\"results\"");
+        if (key == std::string::npos) {
+            throw std::runtime_error("baseline has no results");
+        }
+        pos = key + 9;
+        expect(':');
+        expect('[');
+        std::vector<Result> results;
+        if (peek() == ']') {
+            return results;
+        }
+        do {
+            results.push_back(readObject());
+        } while (accept(','));
+        expect(']');
+        return results;
+    }
+
+private:
+    Result readObject() {
+        Result result;
+        expect('{');
+        if (accept('}')) {
+            return result;
+        }
+        do {
+            std::string key = readString();
+            expect(':');
+            if (peek() == '"') {
+                std::string value = readString();
+                if (key == "name") {
+                    result.name = value;
+                }
+            } else {
+                result.metrics[key] = readNumber();
+            }
+        } while (accept(','));
+        expect('}');
+        return result;
+    }
+
+    std::string readString() {
+        expect('"');
+        std::string value;
+        while (pos < text.size() && text[pos] != '"') {
+            if (text[pos] == '\\' && pos + 1 < text.size()) {
+                pos++;
+            }
+            value += text[pos++];
+        }
+        expect('"');
+        return value;
+    }
+
+    double readNumber() {
+        size_t length = 0;
+        double value = std::stod(text.substr(pos, 64), &length);
+        pos += length;
+        return value;
+    }
+
+    char peek() {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+            pos++;
+        }
+        return pos < text.size() ? text[pos] : '\0';
+    }
+
+    bool accept(char c) {
+        if (peek() == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!accept(c)) {
+            throw std::runtime_error(std::string("baseline: expected '") + c + "' at offset " + std::to_string(pos));
+        }
+    }
+
+    std::string text;
+    size_t pos = 0;
+};
+
+// prints every metric next to its baseline, returns the number of regressions
+int compareWithBaseline(const std::vector<Result> &results, const std::string &path, double threshold) {
+    std::ifstream file{path};
+    if (!file) {
+        throw std::runtime_error("failed to open baseline " + path);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    std::map<std::string, Result> baseline;
+    for (auto &result : JsonReader{text.str()}.readResults()) {
+        baseline[result.name] = std::move(result);
+    }
+
+    int regressions = 0;
+    std::cout << "\ncompared with " << path << " (threshold " << threshold << "%):\n";
+    for (const auto &result : results) {
+        auto old = baseline.find(result.name);
+        if (old == baseline.end()) {
+            continue;
+        }
+        for (const auto &metric : result.metrics) {
+            auto oldMetric = old->second.metrics.find(metric.first);
+            if (oldMetric == old->second.metrics.end() || oldMetric->second <= 0.0) {
+                continue;
+            }
+            bool higherIsBetter = metric.first.size() > 6 &&
+                                  metric.first.compare(metric.first.size() - 6, 6, "_per_s") == 0;
+            bool tail = metric.first == "p95_ms" || metric.first == "p99_ms";
+            bool gated = !tail || result.samples >= MIN_TAIL_SAMPLES;
+            double change = 100.0 * (metric.second - oldMetric->second) / oldMetric->second;
+            double worse = higherIsBetter ? -change : change;
+            bool regressed = gated && worse > threshold;
+            regressions += regressed ? 1 : 0;
+            std::cout << (regressed ? "REGRESSION " : gated ? "           " : "not gated  ") << std::left << std::setw(24) << result.name
+                      << std::setw(18) << metric.first << std::right << std::fixed << std::setprecision(3)
+                      << std::setw(16) << oldMetric->second << " -> " << std::setw(16) << metric.second
+                      << std::setprecision(1) << std::showpos << std::setw(9) << change << "%" << std::noshowpos
+                      << "\n";
+        }
+    }
+    return regressions;
+}
+
+int intOption(const std::string &arg, const std::string &prefix) {
+    return std::stoi(arg.substr(prefix.size()));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto has = [&arg](const char *prefix) { return arg.rfind(prefix, 0) == 0; };
+        if (has("--json=")) {
+            options.jsonPath = arg.substr(7);
+        } else if (has("--baseline=")) {
+            options.baselinePath = arg.substr(11);
+        } else if (has("--threshold=")) {
+            options.threshold = std::stod(arg.substr(12));
+        } else if (has("--frames=")) {
+            options.frames = intOption(arg, "--frames=");
+        } else if (has("--min-depth=")) {
+            options.minDepth = intOption(arg, "--min-depth=");
+        } else if (has("--max-depth=")) {
+            options.maxDepth = intOption(arg, "--max-depth=");
+        } else if (has("--upload-depth=")) {
+            options.uploadDepth = intOption(arg, "--upload-depth=");
+        } else if (has("--render-depth=")) {
+            options.renderDepth = intOption(arg, "--render-depth=");
+        } else if (has("--record-objects=")) {
+            options.recordObjects = std::max(1, intOption(arg, "--record-objects="));
+        } else if (has("--runs=")) {
+            options.runs = std::max(1, intOption(arg, "--runs="));
+        } else {
+            std::cerr << "unknown option: " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<Result> results;
+    try {
+        benchGeneration(options, results);
+        {
+            // no window: no surface, no swap chain, works on lavapipe
+            lve::LveDevice device{nullptr};
+            benchUpload(device, options, results);
+            benchRender(device, options, lve::RenderMode::Vertices, "vertices", results);
+            if (options.renderDepth - 1 <= lve::LveModel::maxExactLevel(lve::VertexFormat::Packed16)) {
+                benchRender(
+                    device, options, lve::RenderMode::Vertices, "vertices-packed16", results,
+                    {lve::VertexFormat::Packed16});
+            }
+            benchRender(
+                device, options, lve::RenderMode::Vertices, "vertices-packed32", results, {lve::VertexFormat::Packed32});
+            benchRender(
+                device, options, lve::RenderMode::Vertices, "vertices-indexed", results,
+                {lve::VertexFormat::Float, true});
+            benchRender(
+                device, options, lve::RenderMode::Vertices, "vertices-arena", results,
+                {lve::VertexFormat::Float, false, true});
+            benchRender(device, options, lve::RenderMode::Procedural, "procedural", results);
+            benchCulled(device, options, options.renderDepth, results);
+            if (options.renderDepth <= lve::CulledRenderSystem::MAX_LEVEL) {
+                benchCulled(device, options, lve::CulledRenderSystem::MAX_LEVEL + 1, results);
+            }
+            benchRecording(device, options, results);
+            benchIndirect(device, options, results);
+            benchRecreate(device, options, results);
+        }
+
+        writeJson(std::cout, results);
+        if (!options.jsonPath.empty()) {
+            std::ofstream file{options.jsonPath};
+            writeJson(file, results);
+            if (!file) {
+                throw std::runtime_error("failed to write " + options.jsonPath);
+            }
+        }
+        if (!options.baselinePath.empty() &&
+            compareWithBaseline(results, options.baselinePath, options.threshold) > 0) {
+            return EXIT_FAILURE;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,31 @@
+# Turns a SPIR-V binary into a header with the words as a constexpr uint32_t array, so the shaders are
+# part of the executable and nothing is read from disk at runtime.
+# usage: cmake -DSPIRV=in.spv -DHEADER=out.hpp -DNAME=identifier -P embed_spirv.cmake
+
+file(READ ${SPIRV} bytes HEX)
+string(LENGTH "${bytes}" length)
+math(EXPR remainder "${length} % 8")
+if(length EQUAL 0 OR NOT remainder EQUAL 0)
+    message(FATAL_ERROR "${SPIRV} is not a SPIR-V binary (size is not a multiple of 4 bytes)")
+endif()
+
+# glslc writes little endian words, swap every group of four bytes into one 0x........ literal
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u," words "${bytes}")
+# 8 words per line (cmake regexes have no {n})
+set(word "0x[0-9a-f]+u,")
+string(REGEX REPLACE "(${word}${word}${word}${word}${word}${word}${word}${word})" "\\1\n    " words "${words}")
+
+file(WRITE ${HEADER}
+"// generated from ${SPIRV} by cmake/embed_spirv.cmake, do not edit
+#pragma once
+
+#include <cstdint>
+
+namespace lve::shaders {
+
+alignas(4) inline constexpr uint32_t ${NAME}[] = {
+    ${words}
+};
+
+} // namespace lve::shaders
+")
@@ -1,2 +0,0 @@
-/usr/local/bin/glslc shaders/simple_shader.vert -o shaders/simple_shader.vert.spv
-/usr/local/bin/glslc shaders/simple_shader.frag -o shaders/simple_shader.frag.spv
\ No newline at end of file
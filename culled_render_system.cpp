@@ -0,0 +1,470 @@
+#include "culled_render_system.hpp"
+#include "shaders/culled_shader.vert.hpp"
+#include "shaders/indirect_shader.frag.hpp"
+#include "shaders/sierpinski_cull.comp.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace {
+
+constexpr uint32_t LEVEL_COUNT = lve::CulledRenderSystem::MAX_LEVEL + 1;
+
+// matches local_size_x in sierpinski_cull.comp
+constexpr uint32_t WORKGROUP_SIZE = 64;
+
+// one per object, std430 layout of ObjectData in sierpinski_cull.comp
+struct CullObjectData {
+    // columns of the mat2
+    glm::vec4 transform;
+    glm::vec2 offset;
+    int32_t depth;
+    uint32_t firstInstance;
+    uint32_t instanceCapacity;
+    uint32_t padding[3];
+};
+static_assert(sizeof(CullObjectData) == 48, "must match the std430 layout in the shader");
+
+// Node in sierpinski_cull.comp
+struct CullNode {
+    glm::vec2 offset;
+    uint32_t object;
+    uint32_t padding;
+};
+static_assert(sizeof(CullNode) == 16, "must match the std430 layout in the shader");
+
+// Control in sierpinski_cull.comp, reset with vkCmdUpdateBuffer every frame
+struct CullControl {
+    // VkDispatchIndirectCommand padded to a uvec4
+    uint32_t dispatch[LEVEL_COUNT][4];
+    uint32_t nodeCount[LEVEL_COUNT];
+};
+static_assert(sizeof(CullControl) <= 65536, "vkCmdUpdateBuffer limit");
+
+struct CullPushConstantData {
+    glm::vec2 viewport;
+    float threshold;
+    // -1 runs the finish pass
+    int32_t level;
+    int32_t lastLevel;
+    uint32_t objectCount;
+    uint32_t nodeCapacity;
+};
+
+struct CulledPushConstantData {
+    glm::mat2 transform{1.f};
+    glm::vec2 offset;
+    alignas(16) glm::vec4 color;
+};
+
+uint64_t powerOfThree(int exponent) {
+    uint64_t value = 1;
+    for (int i = 0; i < exponent; i++) {
+        value *= 3;
+    }
+    return value;
+}
+
+uint32_t workgroupCount(uint32_t invocations) {
+    return (invocations + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+}
+
+} // namespace
+
+namespace lve {
+
+CulledRenderSystem::CulledRenderSystem(
+    LveDevice& device, VkRenderPass renderPass, int frameSlots, VkExtent2D extent, float pixelThreshold)
+    : lveDevice{device},
+      renderPass{renderPass},
+      pixelThreshold{pixelThreshold},
+      pipelines{[this](const bool& blended) { return createPipeline(blended); }},
+      frames(frameSlots) {
+    if (!(pixelThreshold > 0.0f)) {
+        throw std::runtime_error("the culling threshold has to be a positive number of pixels");
+    }
+    // a scale 1 root triangle spans the whole viewport, every level halves it
+    float extentPixels = static_cast<float>(std::max(extent.width, extent.height));
+    splitLevelCount = 0;
+    while (splitLevelCount < MAX_LEVEL && std::ldexp(extentPixels, -splitLevelCount) >= pixelThreshold) {
+        splitLevelCount++;
+    }
+
+    createDescriptorSetLayout();
+    createPipelineLayouts();
+    createDescriptorPool(frameSlots);
+    cullPipeline = std::make_unique<LveComputePipeline>(lveDevice, shaders::sierpinski_cull_comp, cullPipelineLayout);
+    pipelines.get(false);
+    pipelines.get(true);
+}
+
+CulledRenderSystem::~CulledRenderSystem() {
+    for (auto& frame : frames) {
+        destroyBuffers(frame);
+    }
+    cullPipeline = nullptr;
+    // frees the sets as well
+    vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+    vkDestroyPipelineLayout(lveDevice.device(), drawPipelineLayout, nullptr);
+    vkDestroyPipelineLayout(lveDevice.device(), cullPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+}
+
+void CulledRenderSystem::createDescriptorSetLayout() {
+    // objects, nodes, control, draws, instances
+    std::array<VkDescriptorSetLayoutBinding, 5> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout");
+    }
+}
+
+void CulledRenderSystem::createPipelineLayouts() {
+    VkPushConstantRange cullPushRange{};
+    cullPushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    cullPushRange.offset = 0;
+    cullPushRange.size = sizeof(CullPushConstantData);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &cullPushRange;
+    if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout");
+    }
+
+    // drawing reads the instances as a vertex buffer, no descriptors
+    VkPushConstantRange drawPushRange{};
+    drawPushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    drawPushRange.offset = 0;
+    drawPushRange.size = sizeof(CulledPushConstantData);
+
+    pipelineLayoutInfo.setLayoutCount = 0;
+    pipelineLayoutInfo.pSetLayouts = nullptr;
+    pipelineLayoutInfo.pPushConstantRanges = &drawPushRange;
+    if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &drawPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout");
+    }
+}
+
+void CulledRenderSystem::createDescriptorPool(int frameSlots) {
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 5 * static_cast<uint32_t>(frameSlots);
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = static_cast<uint32_t>(frameSlots);
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool");
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(frameSlots, descriptorSetLayout);
+    std::vector<VkDescriptorSet> descriptorSets(frameSlots);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(frameSlots);
+    allocInfo.pSetLayouts = setLayouts.data();
+    if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor sets");
+    }
+    for (int slot = 0; slot < frameSlots; slot++) {
+        frames[slot].descriptorSet = descriptorSets[slot];
+    }
+}
+
+std::unique_ptr<LvePipeline> CulledRenderSystem::createPipeline(bool blended) {
+    assert(drawPipelineLayout != nullptr && "cannot create pipeline before pipeline layout");
+    PipelineConfigInfo pipelineConfig{};
+    LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.pipelineLayout = drawPipelineLayout;
+
+    // indirect_shader.frag: constant_id 0 = BLENDED
+    pipelineConfig.colorBlendAttachment.blendEnable = blended ? VK_TRUE : VK_FALSE;
+    pipelineConfig.fragSpecialization.set(0, blended);
+
+    // no vertices, the corners come from gl_VertexIndex; one (offset, scale) per instance
+    VkVertexInputBindingDescription instanceBinding{};
+    instanceBinding.binding = 0;
+    instanceBinding.stride = sizeof(glm::vec4);
+    instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    VkVertexInputAttributeDescription instanceAttribute{};
+    instanceAttribute.binding = 0;
+    instanceAttribute.location = 0;
+    instanceAttribute.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    instanceAttribute.offset = 0;
+    pipelineConfig.bindingDescriptions = {instanceBinding};
+    pipelineConfig.attributeDescriptions = {instanceAttribute};
+
+    return std::make_unique<LvePipeline>(
+        lveDevice, shaders::culled_shader_vert, shaders::indirect_shader_frag, pipelineConfig);
+}
+
+uint32_t CulledRenderSystem::instanceCapacity(int depth) const {
+    // every split node turns one leaf into three, and only the levels above splitLevelCount split
+    return static_cast<uint32_t>(std::min<uint64_t>(powerOfThree(std::min(depth, splitLevelCount)), UINT32_MAX));
+}
+
+uint32_t CulledRenderSystem::nodeCapacity(const std::vector<LveGameObject>& gameObjects) const {
+    // level k holds at most 3^k nodes of every object at least k deep, and nothing below splitLevelCount
+    uint64_t capacity = 3;
+    for (int level = 1; level <= splitLevelCount; level++) {
+        auto objects = std::count_if(gameObjects.begin(), gameObjects.end(), [level](const LveGameObject& obj) {
+            return obj.depth >= level;
+        });
+        capacity = std::max<uint64_t>(capacity, powerOfThree(level) * static_cast<uint64_t>(objects));
+    }
+    // both halves have to fit in one storage buffer binding
+    // and one level has to fit in one indirect dispatch
+    uint64_t limit = std::min<uint64_t>(
+        lveDevice.properties.limits.maxStorageBufferRange / (2 * sizeof(CullNode)),
+        static_cast<uint64_t>(lveDevice.properties.limits.maxComputeWorkGroupCount[0]) * WORKGROUP_SIZE);
+    capacity = std::min(capacity, limit);
+    // children are appended in threes, a multiple of 3 is never left partially written
+    return static_cast<uint32_t>(capacity - capacity % 3);
+}
+
+void CulledRenderSystem::createBuffer(
+    Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties) {
+    lveDevice.createBuffer(size, usage, properties, buffer.buffer, buffer.memory);
+}
+
+void CulledRenderSystem::destroyBuffer(Buffer& buffer) {
+    if (buffer.buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(lveDevice.device(), buffer.buffer, nullptr);
+        lveDevice.allocator().free(buffer.memory);
+        buffer.buffer = VK_NULL_HANDLE;
+    }
+}
+
+void CulledRenderSystem::destroyBuffers(Frame& frame) {
+    destroyBuffer(frame.objects);
+    destroyBuffer(frame.nodes);
+    destroyBuffer(frame.control);
+    destroyBuffer(frame.draws);
+    destroyBuffer(frame.instances);
+}
+
+void CulledRenderSystem::reserve(Frame& frame, uint32_t objectCount, uint32_t nodeCount, uint32_t instanceCount) {
+    if (objectCount <= frame.objectCapacity && nodeCount <= frame.nodeCapacity &&
+        instanceCount <= frame.instanceCapacity) {
+        return;
+    }
+    // the slot's last frame is done, nothing on the gpu uses the old buffers anymore
+    destroyBuffers(frame);
+    frame.objectCapacity = std::max({frame.objectCapacity, objectCount, 16u});
+    frame.nodeCapacity = std::max(frame.nodeCapacity, nodeCount);
+    frame.instanceCapacity = std::max({frame.instanceCapacity, instanceCount, 1u});
+
+    createBuffer(
+        frame.objects,
+        sizeof(CullObjectData) * frame.objectCapacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    createBuffer(
+        frame.nodes,
+        2 * sizeof(CullNode) * frame.nodeCapacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    createBuffer(
+        frame.control,
+        sizeof(CullControl),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    createBuffer(
+        frame.draws,
+        sizeof(VkDrawIndirectCommand) * frame.objectCapacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    createBuffer(
+        frame.instances,
+        sizeof(glm::vec4) * frame.instanceCapacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    std::array<VkDescriptorBufferInfo, 5> bufferInfos{};
+    bufferInfos[0] = {frame.objects.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[1] = {frame.nodes.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[2] = {frame.control.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[3] = {frame.draws.buffer, 0, VK_WHOLE_SIZE};
+    bufferInfos[4] = {frame.instances.buffer, 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = frame.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = static_cast<uint32_t>(bufferInfos.size());
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = bufferInfos.data();
+    vkUpdateDescriptorSets(lveDevice.device(), 1, &write, 0, nullptr);
+}
+
+void CulledRenderSystem::cull(
+    VkCommandBuffer commandBuffer,
+    int frameSlot,
+    const std::vector<LveGameObject>& gameObjects,
+    VkExtent2D extent,
+    LveGpuProfiler* profiler) {
+    if (gameObjects.empty()) {
+        return;
+    }
+    Frame& frame = frames[frameSlot];
+    auto objectCount = static_cast<uint32_t>(gameObjects.size());
+
+    // every object gets its own instance range, so the objects keep their draw order
+    // and the fading one can still be blended on its own
+    uint64_t instanceLimit = lveDevice.properties.limits.maxStorageBufferRange / sizeof(glm::vec4) / objectCount;
+    std::vector<uint32_t> capacities(objectCount);
+    frame.firstInstances.resize(objectCount);
+    uint32_t instanceCount = 0;
+    int deepest = 0;
+    for (uint32_t i = 0; i < objectCount; i++) {
+        int depth = std::min(gameObjects[i].depth, MAX_LEVEL);
+        capacities[i] = static_cast<uint32_t>(std::min<uint64_t>(instanceCapacity(depth), instanceLimit));
+        frame.firstInstances[i] = instanceCount;
+        instanceCount += capacities[i];
+        deepest = std::max(deepest, depth);
+    }
+    reserve(frame, objectCount, nodeCapacity(gameObjects), instanceCount);
+
+    // host coherent, the writes are visible to the gpu once the frame is submitted
+    auto* objects = static_cast<CullObjectData*>(frame.objects.memory.mapped);
+    for (uint32_t i = 0; i < objectCount; i++) {
+        const auto& obj = gameObjects[i];
+        glm::mat2 transform = obj.transform2d.mat2();
+        objects[i] = {};
+        objects[i].transform = {transform[0], transform[1]};
+        objects[i].offset = obj.transform2d.translation;
+        objects[i].depth = std::min(obj.depth, MAX_LEVEL);
+        objects[i].firstInstance = frame.firstInstances[i];
+        objects[i].instanceCapacity = capacities[i];
+    }
+
+    uint32_t scope = profiler ? profiler->beginScope(commandBuffer, "cull") : UINT32_MAX;
+
+    // empty levels and counters, every emit counter back to zero
+    CullControl control{};
+    for (auto& dispatch : control.dispatch) {
+        dispatch[1] = 1;
+        dispatch[2] = 1;
+    }
+    vkCmdUpdateBuffer(commandBuffer, frame.control.buffer, 0, sizeof(control), &control);
+    vkCmdFillBuffer(commandBuffer, frame.draws.buffer, 0, sizeof(VkDrawIndirectCommand) * objectCount, 0);
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    cullPipeline->bind(commandBuffer);
+    vkCmdBindDescriptorSets(
+        commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+
+    // below splitLevelCount every node is under the threshold (for scale 1 objects), the walk ends there
+    int lastLevel = std::min(deepest, splitLevelCount);
+    CullPushConstantData push{};
+    push.viewport = {static_cast<float>(extent.width), static_cast<float>(extent.height)};
+    push.threshold = pixelThreshold;
+    push.lastLevel = lastLevel;
+    push.objectCount = objectCount;
+    push.nodeCapacity = frame.nodeCapacity;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    for (int level = 0; level <= lastLevel; level++) {
+        push.level = level;
+        vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+        if (level == 0) {
+            // one root per object, known on the cpu
+            vkCmdDispatch(commandBuffer, workgroupCount(objectCount), 1, 1);
+        } else {
+            vkCmdDispatchIndirect(commandBuffer, frame.control.buffer, offsetof(CullControl, dispatch) + 16 * level);
+        }
+
+        // the next level reads the nodes, counters and dispatch size this one wrote
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    push.level = -1;
+    vkCmdPushConstants(commandBuffer, cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vkCmdDispatch(commandBuffer, workgroupCount(objectCount), 1, 1);
+
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    if (profiler) {
+        profiler->endScope(commandBuffer, scope);
+    }
+}
+
+void CulledRenderSystem::renderGameObjects(
+    VkCommandBuffer commandBuffer, int frameSlot, const std::vector<LveGameObject>& gameObjects, LveGpuProfiler* profiler) {
+    Frame& frame = frames[frameSlot];
+    assert(frame.firstInstances.size() == gameObjects.size() && "cull() has to run first with the same objects");
+    if (gameObjects.empty()) {
+        return;
+    }
+
+    uint32_t scope = profiler ? profiler->beginScope(commandBuffer, "culled draws") : UINT32_MAX;
+    LvePipeline* boundPipeline = nullptr;
+    for (uint32_t i = 0; i < gameObjects.size(); i++) {
+        const auto& obj = gameObjects[i];
+        LvePipeline* pipeline = &pipelines.get(obj.alpha < 1.0f);
+        if (pipeline != boundPipeline) {
+            pipeline->bind(commandBuffer);
+            boundPipeline = pipeline;
+        }
+
+        CulledPushConstantData push{};
+        push.transform = obj.transform2d.mat2();
+        push.offset = obj.transform2d.translation;
+        push.color = {obj.color, obj.alpha};
+        vkCmdPushConstants(commandBuffer, drawPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+
+        // the object's range as the instance buffer, firstInstance stays 0 and needs no device feature
+        VkDeviceSize offset = sizeof(glm::vec4) * frame.firstInstances[i];
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &frame.instances.buffer, &offset);
+        vkCmdDrawIndirect(
+            commandBuffer, frame.draws.buffer, sizeof(VkDrawIndirectCommand) * i, 1, sizeof(VkDrawIndirectCommand));
+    }
+    if (profiler) {
+        profiler->endScope(commandBuffer, scope);
+    }
+}
+
+} // namespace lve
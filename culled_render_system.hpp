@@ -0,0 +1,112 @@
+#pragma once
+
+#include "lve_compute_pipeline.hpp"
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_pipeline_builder.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+    // Draws the game objects' levels without generating them, at a cost set by the screen instead of
+    // the depth. Before the render pass shaders/sierpinski_cull.comp walks every object's Sierpinski
+    // hierarchy top-down, one dispatch per level: sub-triangles outside the viewport are dropped,
+    // the ones smaller than pixelThreshold pixels stop there and are drawn as one covering triangle,
+    // the rest are split into their three children. The survivors are compacted into a per object
+    // range of an instance buffer and counted into the object's VkDrawIndirectCommand, so inside the
+    // render pass every object is a single vkCmdDrawIndirect of the root triangle.
+    // The walk stops at the first level below the threshold, so at 800x600 and 1 pixel a depth 13
+    // object is drawn with at most 3^10 instead of 3^13 triangles and deeper ones cost nothing more.
+    // Each level's dispatch size is written by the level above (vkCmdDispatchIndirect), the cpu only
+    // records one dispatch per level that can still be split.
+    class CulledRenderSystem {
+        public:
+        // deepest level the walk reaches, offsets and scales are exact floats down to here
+        static constexpr int MAX_LEVEL = 23;
+
+        // extent and pixelThreshold size the buffers: nothing in a scale 1 object smaller than the
+        // threshold is split. Larger objects or a larger window still work, sub-triangles that don't
+        // fit are drawn coarser.
+        CulledRenderSystem(
+            LveDevice& device,
+            VkRenderPass renderPass,
+            int frameSlots,
+            VkExtent2D extent,
+            float pixelThreshold = 1.0f);
+        ~CulledRenderSystem();
+        CulledRenderSystem(const CulledRenderSystem&) = delete;
+        CulledRenderSystem& operator=(const CulledRenderSystem&) = delete;
+
+        // outside the render pass: walks the objects' hierarchies into frameSlot's draw commands;
+        // frameSlot's previous frame has to be finished (LveRenderer::beginFrame waits for it)
+        void cull(
+            VkCommandBuffer commandBuffer,
+            int frameSlot,
+            const std::vector<LveGameObject>& gameObjects,
+            VkExtent2D extent,
+            LveGpuProfiler* profiler = nullptr);
+        // inside the render pass, with the objects cull() was given for the same frame slot
+        void renderGameObjects(
+            VkCommandBuffer commandBuffer,
+            int frameSlot,
+            const std::vector<LveGameObject>& gameObjects,
+            LveGpuProfiler* profiler = nullptr);
+
+        // levels that can still be split at the extent and threshold given to the constructor
+        int splitLevels() const { return splitLevelCount; }
+
+    private:
+        struct Buffer {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            LveAllocation memory{};
+        };
+
+        struct Frame {
+            // CullObjectData, written by the cpu every frame
+            Buffer objects;
+            // the rest is only touched by the gpu
+            Buffer nodes;
+            Buffer control;
+            Buffer draws;
+            Buffer instances;
+            uint32_t objectCapacity = 0;
+            uint32_t nodeCapacity = 0;
+            uint32_t instanceCapacity = 0;
+            // start of each object's instance range, filled by cull()
+            std::vector<uint32_t> firstInstances;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        };
+
+        void createDescriptorSetLayout();
+        void createPipelineLayouts();
+        void createDescriptorPool(int frameSlots);
+        std::unique_ptr<LvePipeline> createPipeline(bool blended);
+        // most instances one object can emit: a cut through the levels above the threshold
+        uint32_t instanceCapacity(int depth) const;
+        // most nodes all objects together can have on one level
+        uint32_t nodeCapacity(const std::vector<LveGameObject>& gameObjects) const;
+        void reserve(Frame& frame, uint32_t objectCount, uint32_t nodeCount, uint32_t instanceCount);
+        void createBuffer(Buffer& buffer, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+        void destroyBuffer(Buffer& buffer);
+        void destroyBuffers(Frame& frame);
+
+        LveDevice& lveDevice;
+        VkRenderPass renderPass;
+        float pixelThreshold;
+        int splitLevelCount;
+
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkPipelineLayout cullPipelineLayout = VK_NULL_HANDLE;
+        VkPipelineLayout drawPipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<LveComputePipeline> cullPipeline;
+        // keyed by blended, like SimpleRenderSystem only the fading object needs blending
+        LvePipelineVariants<bool> pipelines;
+        std::vector<Frame> frames;
+    };
+}
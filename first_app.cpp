@@ -1,5 +1,8 @@
 #include "first_app.hpp"
-#include "simple_render_system.hpp"
+#include "lve_trace.hpp"
+#include "sierpinski_compute.hpp"
+#include "sierpinski_generator.hpp"
+#include "sierpinski_level.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -7,38 +10,176 @@
 #include <glm/gtc/constants.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <chrono>
 #include <stdexcept>
 
 namespace lve {
 
-FirstApp::FirstApp() {
-    loadGameObjects();
+FirstApp::FirstApp(const FirstAppConfig &config) : config{config} {
+    if (config.maxDepth < 0) {
+        throw std::runtime_error("the number of levels can't be negative");
+    }
+    if (config.maxDepth > 0) {
+        maxDepth = config.maxDepth;
+    }
+    if (config.renderMode == RenderMode::Procedural && !config.gpuCulling &&
+        maxDepth - 1 > SimpleRenderSystem::MAX_PROCEDURAL_DEPTH) {
+        // 3 * 3^level vertices have to fit the 32 bit vertex index
+        throw std::runtime_error(
+            "--render-mode=procedural goes down to level " + std::to_string(SimpleRenderSystem::MAX_PROCEDURAL_DEPTH) +
+            ", use --max-depth=" + std::to_string(SimpleRenderSystem::MAX_PROCEDURAL_DEPTH + 1) + " or less");
+    }
+    if (config.gpuGeneration && config.renderMode != RenderMode::Vertices) {
+        // the other modes don't draw the generated vertex buffers
+        throw std::runtime_error("--gpu-generation needs --render-mode=vertices");
+    }
+    if (config.indexed && (config.renderMode != RenderMode::Vertices || config.gpuGeneration)) {
+        throw std::runtime_error("--indexed needs --render-mode=vertices and cpu generation");
+    }
+    if (config.gpuCulling) {
+        if (config.indexed || config.vertexFormat != VertexFormat::Float || config.gpuGeneration || config.indirect) {
+            throw std::runtime_error(
+                "--gpu-culling draws without vertex buffers, it can't be combined with --indexed, --vertex-format, "
+                "--gpu-generation or --indirect");
+        }
+        if (maxDepth - 1 > CulledRenderSystem::MAX_LEVEL) {
+            throw std::runtime_error(
+                "gpu culling goes down to level " + std::to_string(CulledRenderSystem::MAX_LEVEL) + ", use --max-depth=" +
+                std::to_string(CulledRenderSystem::MAX_LEVEL + 1) + " or less");
+        }
+    }
+    if (config.vertexFormat != VertexFormat::Float) {
+        if (config.renderMode != RenderMode::Vertices || config.gpuGeneration) {
+            throw std::runtime_error("packed vertex formats need --render-mode=vertices and cpu generation");
+        }
+        if (maxDepth - 1 > LveModel::maxExactLevel(config.vertexFormat)) {
+            throw std::runtime_error(
+                "the vertex format is exact up to level " + std::to_string(LveModel::maxExactLevel(config.vertexFormat)) +
+                ", use --max-depth=" + std::to_string(LveModel::maxExactLevel(config.vertexFormat) + 1) + " or less");
+        }
+    }
+    if (!config.tracePath.empty()) {
+        LveTrace::setThreadName("main");
+        LveTrace::start();
+    }
+    if (!config.recordPath.empty()) {
+        if (lveRenderer->getOffscreenTarget() == nullptr) {
+            throw std::runtime_error("recording needs the headless renderer");
+        }
+        auto sink = config.recordPath == "-" ? LveFrameReadback::rawSink(stdout)
+                                             : LveFrameReadback::pngSequenceSink(config.recordPath);
+        frameReadback = std::make_unique<LveFrameReadback>(
+            lveDevice,
+            VkExtent2D{static_cast<uint32_t>(WIDTH), static_cast<uint32_t>(HEIGHT)},
+            lveRenderer->getFramesInFlight(),
+            std::move(sink));
+    }
+    {
+        LveTraceZone zone{"loadGameObjects"};
+        loadGameObjects();
+    }
+
+    // the uploader is gone by now, so this is what the models and the swap chain keep
+    auto stats = lveDevice.allocator().stats();
+    std::cout << "gpu memory: " << stats.liveBytes / 1024 << " KiB in " << stats.allocationCount << " allocations, "
+              << stats.blockCount << " blocks (" << stats.reservedBytes / 1024 << " KiB), fragmentation "
+              << stats.fragmentation << std::endl;
 }
 
 FirstApp::~FirstApp() {
 }
 
+std::unique_ptr<LveRenderer> FirstApp::createRenderer() {
+    if (config.headless) {
+        return std::make_unique<LveRenderer>(
+            lveDevice, VkExtent2D{static_cast<uint32_t>(WIDTH), static_cast<uint32_t>(HEIGHT)}, config.framesInFlight);
+    }
+    return std::make_unique<LveRenderer>(*lveWindow, lveDevice, config.framesInFlight);
+}
+
 void FirstApp::run() {
-    SimpleRenderSystem simpleRendereSystem{lveDevice, lveRenderer.getSwapChainRenderPass()};
+    SimpleRenderSystem simpleRendereSystem{lveDevice, lveRenderer->getSwapChainRenderPass(), config.renderMode, maxDepth, &pipelineBuilder, config.vertexFormat};
+    std::unique_ptr<CulledRenderSystem> culledRenderSystem;
+    if (config.gpuCulling) {
+        culledRenderSystem = std::make_unique<CulledRenderSystem>(
+            lveDevice,
+            lveRenderer->getSwapChainRenderPass(),
+            lveRenderer->getFramesInFlight(),
+            lveRenderer->getExtent(),
+            config.cullThreshold);
+        std::cout << "gpu culling: sub-triangles below " << config.cullThreshold << " pixels are not split, at most "
+                  << culledRenderSystem->splitLevels() << " levels walked per frame" << std::endl;
+    }
+    std::unique_ptr<IndirectRenderSystem> indirectRenderSystem;
+    if (config.indirect) {
+        if (IndirectRenderSystem::canDraw(gameObjects)) {
+            indirectRenderSystem = std::make_unique<IndirectRenderSystem>(
+                lveDevice, lveRenderer->getSwapChainRenderPass(), lveRenderer->getFramesInFlight(), config.vertexFormat);
+            std::cout << "indirect drawing"
+                      << (indirectRenderSystem->usesMultiDraw() ? " with multi draw" : ", one call per object (no multiDrawIndirect)")
+                      << std::endl;
+        } else {
+            std::cout << "indirect drawing needs every level in the mesh arena (cpu generated vertices), drawing directly"
+                      << std::endl;
+        }
+    }
+    // threadPool also builds pipelines in the background, waiting for the chunks there could pick up a
+    // compile; declared before the recorder, which uses it until it is destroyed
+    std::unique_ptr<LveThreadPool> recordingPool;
+    std::unique_ptr<LveParallelRecorder> recorder;
+    if (config.parallelRecording && !indirectRenderSystem && !culledRenderSystem) {
+        recordingPool = std::make_unique<LveThreadPool>();
+        recorder = std::make_unique<LveParallelRecorder>(
+            lveDevice, *recordingPool, lveRenderer->getFramesInFlight(), config.recordingChunks);
+        std::cout << "recording draws into " << recorder->chunkCount() << " secondary command buffers" << std::endl;
+    } else if (config.parallelRecording) {
+        std::cout << "--parallel-recording is ignored, " << (culledRenderSystem ? "gpu culling" : "indirect drawing")
+                  << " records a few commands per frame on one thread" << std::endl;
+    }
     int currentDepth = -1;
     bool delayFlag = false;
     std::cout << "max push conts size = " << lveDevice.properties.limits.maxPushConstantsSize << "\n";
     float eraseTreshold = 0.01f;
     auto currentTime = std::chrono::high_resolution_clock::now();
     std::chrono::high_resolution_clock::time_point lastTime = currentTime;
-    while (!lveWindow.shouldClose()) {
+    int framesSinceLastPrint = 0;
+    bool traceKeyWasPressed = false;
+    int traceParts = 0;
+    int frameCount = 0;
+    while (lveWindow ? !lveWindow->shouldClose() : frameCount < config.headlessFrames) {
+        LveTraceZone frameZone{"frame"};
 
         currentTime = std::chrono::high_resolution_clock::now();
         timeDifference = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - lastTime).count();
 
         if (timeDifference >= 1.f) {
-            std::cout<< "FPS: " << 1.f/timeDifference << std::endl;
+            // overlap: share of the time the cpu kept working while the gpu rendered, instead of waiting for it
+            double gpuWait = lveRenderer->takeGpuWaitTime();
+            int frames = std::max(framesSinceLastPrint, 1);
+            std::cout<< "FPS: " << framesSinceLastPrint/timeDifference
+                     << " (" << 1000.f * timeDifference / frames << " ms/frame, "
+                     << 1000.0 * gpuWait / frames << " ms waiting for the gpu, cpu/gpu overlap "
+                     << 100.0 * (1.0 - gpuWait / timeDifference) << "% with "
+                     << lveRenderer->getFramesInFlight() << " frames in flight)" << std::endl;
+            if (frameReadback) {
+                std::cout << "recorded " << frameReadback->framesWritten() << " frames, "
+                          << 1000.0 * frameReadback->takeStallTime() / frames << " ms/frame waiting for the encoder"
+                          << std::endl;
+            }
+            lveRenderer->getGpuProfiler().printReport(std::cout);
+            lveRenderer->getGpuProfiler().reset();
+            framesSinceLastPrint = 0;
             std::cout<< "memory: " << gameObjects.size() << std::endl;
             float offset = static_cast<float>(gameObjects.size());
             lastTime = currentTime;
             if(currentDepth < maxDepth - 2){
+                // the frames in flight may still draw the model of this object, the renderer frees it once they are done
+                lveRenderer->retire(std::move(gameObjects.front().model));
+                // the arena keeps the level's range (it is never compacted), only the reference goes,
+                // through the queue as well in case it is the last one
+                lveRenderer->retire(std::move(gameObjects.front().meshArena));
                 gameObjects.erase(gameObjects.begin());
             }
             if (currentDepth < maxDepth-1) {
@@ -56,55 +197,177 @@ void FirstApp::run() {
 
         // poll events checks if any events are triggered (like keyboard or mouse input)
         // or dismissed the window etc.
-        glfwPollEvents();
-        if (auto commandBuffer = lveRenderer.beginFrame()) {
-            lveRenderer.beginSwapChainRenderPass(commandBuffer);
-            simpleRendereSystem.renderGameObjects(commandBuffer, gameObjects);
-            lveRenderer.endSwapChainRenderPass(commandBuffer);
-            lveRenderer.endFrame();
+        if (lveWindow) {
+            LveTraceZone zone{"poll events"};
+            glfwPollEvents();
+
+            bool traceKeyPressed = lveWindow->isKeyPressed(GLFW_KEY_F12);
+            if (traceKeyPressed && !traceKeyWasPressed && LveTrace::isEnabled()) {
+                // every write only holds the events since the previous one, so F12 doesn't
+                // overwrite its earlier parts: file.json becomes file.1.json, file.2.json, ...
+                std::string path = config.tracePath;
+                size_t extension = path.rfind('.');
+                if (extension == std::string::npos || path.find('/', extension) != std::string::npos) {
+                    extension = path.size();
+                }
+                path.insert(extension, "." + std::to_string(++traceParts));
+                LveTrace::writeChromeTrace(path);
+                std::cout << "trace written to " << path << std::endl;
+            }
+            traceKeyWasPressed = traceKeyPressed;
         }
 
-        vkDeviceWaitIdle(lveDevice.device());
+        if (auto commandBuffer = lveRenderer->beginFrame()) {
+            {
+                LveTraceZone zone{"record"};
+                if (culledRenderSystem) {
+                    // the compute walk has to finish before the render pass draws what it left
+                    culledRenderSystem->cull(
+                        commandBuffer,
+                        lveRenderer->getFrameIndex(),
+                        gameObjects,
+                        lveRenderer->getExtent(),
+                        &lveRenderer->getGpuProfiler());
+                    lveRenderer->beginSwapChainRenderPass(commandBuffer);
+                    culledRenderSystem->renderGameObjects(
+                        commandBuffer, lveRenderer->getFrameIndex(), gameObjects, &lveRenderer->getGpuProfiler());
+                } else if (indirectRenderSystem) {
+                    // a handful of commands, nothing to spread over threads
+                    lveRenderer->beginSwapChainRenderPass(commandBuffer);
+                    indirectRenderSystem->renderGameObjects(
+                        commandBuffer, lveRenderer->getFrameIndex(), gameObjects, &lveRenderer->getGpuProfiler());
+                } else if (recorder) {
+                    lveRenderer->beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    simpleRendereSystem.renderGameObjects(commandBuffer, gameObjects, *lveRenderer, *recorder);
+                } else {
+                    lveRenderer->beginSwapChainRenderPass(commandBuffer);
+                    simpleRendereSystem.renderGameObjects(commandBuffer, gameObjects, &lveRenderer->getGpuProfiler());
+                }
+                lveRenderer->endSwapChainRenderPass(commandBuffer);
+                if (frameReadback) {
+                    frameReadback->readFrame(
+                        commandBuffer,
+                        lveRenderer->getFrameIndex(),
+                        lveRenderer->getOffscreenTarget()->getColorImage(lveRenderer->getCurrentImageIndex()));
+                }
+            }
+            lveRenderer->endFrame();
+            framesSinceLastPrint++;
+            frameCount++;
+        }
+    }
+    // the last frames are still in flight, they have to finish before anything they use is destroyed
+    vkDeviceWaitIdle(lveDevice.device());
+    if (frameReadback) {
+        frameReadback->finish();
+        std::cout << "recorded " << frameReadback->framesWritten() << " frames" << std::endl;
+    }
+    if (LveTrace::isEnabled()) {
+        LveTrace::writeChromeTrace(config.tracePath);
+        std::cout << "trace written to " << config.tracePath << std::endl;
     }
 }
 
 void FirstApp::loadGameObjects() {
-    std::vector<std::vector<LveModel::Vertex>> vertices;
-    for (int i = 0; i < maxDepth; i++) {
-        vertices.push_back(std::vector<LveModel::Vertex>());
+    std::vector<std::shared_ptr<LveModel>> models;
+    // cpu generated levels share one buffer, every level is a range of it
+    std::shared_ptr<LveMeshArena> arena;
+    std::vector<LveMeshRange> meshes;
+    // all levels go through one staging ring and are copied to device local memory in a single submission
+    LveUploader uploader{lveDevice};
+    if (config.renderMode == RenderMode::Procedural || config.gpuCulling) {
+        // nothing to allocate, the vertex shader (or the culling pass) only needs the depth of each game object
+        models.resize(maxDepth);
+    } else if (config.renderMode == RenderMode::Instanced) {
+        models = createInstancedLevelModels(uploader);
+    } else if (config.gpuGeneration) {
+        models = createGpuLevelModels();
+    } else {
+        arena = createLevelArena(uploader, meshes);
+        models.resize(maxDepth);
     }
+    uploader.flush();
+
+    VkDeviceSize memory = arena ? arena->memorySize() : 0;
     int i = 0;
-    sierpinski(vertices, maxDepth, {-1.f, 1.f}, {1.f, 1.f}, {0.0f, -1.f});
-    for (auto &vertex : vertices) {
-        auto lveModel = std::make_shared<LveModel>(lveDevice, vertex);
+    for (auto &lveModel : models) {
+        if (lveModel) {
+            memory += lveModel->memorySize();
+        }
         auto triangle = LveGameObject::createGameObject();
         triangle.model = lveModel;
+        if (arena) {
+            triangle.meshArena = arena;
+            triangle.mesh = meshes[i];
+        }
         triangle.color = {0.1f, 0.8f, 0.1f};
         triangle.depth = i++;
         gameObjects.push_back(std::move(triangle));
     }
+    std::cout << "vertex memory for " << models.size() << " levels: " << memory / 1024 << " KiB, uploaded in "
+              << uploader.submissionCount() << " submission(s)" << std::endl;
 }
 
-void FirstApp::sierpinski(
-    std::vector<std::vector<LveModel::Vertex>> &vertices,
-    int depth,
-    glm::vec2 left,
-    glm::vec2 right,
-    glm::vec2 top) {
-    std::vector<LveModel::Vertex> triangleVertices = {
-        {top},
-        {right},
-        {left}};
-    vertices[maxDepth - depth].push_back({top});
-    vertices[maxDepth - depth].push_back({right});
-    vertices[maxDepth - depth].push_back({left});
-    if (depth >= 0) {
-        auto topleft = 0.5f * (top + left);
-        auto topright = 0.5f * (top + right);
-        auto rightleft = 0.5f * (right + left);
-        sierpinski(vertices, depth - 1, topleft, left, rightleft);
-        sierpinski(vertices, depth - 1, topright, rightleft, right);
-        sierpinski(vertices, depth - 1, top, topleft, topright);
+std::vector<std::shared_ptr<LveModel>> FirstApp::createGpuLevelModels() {
+    // the levels never touch the cpu, they are expanded by a compute shader into device local vertex buffers
+    SierpinskiComputeGenerator generator{lveDevice};
+    return generator.generate(maxDepth, config.validateGpuGeneration);
+}
+
+std::shared_ptr<LveMeshArena> FirstApp::createLevelArena(LveUploader &uploader, std::vector<LveMeshRange> &meshes) {
+    auto arena = std::make_shared<LveMeshArena>(lveDevice, config.vertexFormat);
+    SierpinskiGenerator generator{threadPool};
+    if (config.indexed) {
+        // unique corners plus indices, about half the vertices and far fewer vertex shader invocations
+        auto levels = generator.generateIndexed(maxDepth);
+        for (auto &level : levels) {
+            meshes.push_back(arena->add(level.vertices, level.indices));
+            // the arena has its own copy, keeps the peak at about one extra level
+            level = {};
+        }
+    } else {
+        // every level is expanded from the previous one with the SIMD kernel, chunks spread over the thread pool,
+        // level 0 is the full triangle
+        auto levels = generator.generateExpanded(maxDepth);
+        for (auto &vertices : levels) {
+            meshes.push_back(arena->add(vertices));
+            vertices = std::vector<LveModel::Vertex>{};
+        }
+    }
+    arena->upload(uploader);
+    return arena;
+}
+
+std::vector<std::shared_ptr<LveModel>> FirstApp::createInstancedLevelModels(LveUploader &uploader) {
+    // All sub-triangles of a level are the root triangle scaled by 2^-k and moved,
+    // so a level is 3 vertices plus one 8 byte offset per sub-triangle.
+    constexpr uint64_t CHUNK_SIZE = 16384;
+    auto root = SierpinskiGenerator::rootTriangle();
+    std::vector<std::shared_ptr<LveModel>> models;
+    for (int level = 0; level < maxDepth; level++) {
+        float scale = std::ldexp(1.0f, -level);
+        std::vector<LveModel::Vertex> vertices(3);
+        vertices[0].position = scale * root.top;
+        vertices[1].position = scale * root.right;
+        vertices[2].position = scale * root.left;
+
+        uint64_t count = SierpinskiLevel::triangleCount(level);
+        std::vector<LveModel::Instance> instances(count);
+        LveThreadPool::TaskGroup group;
+        for (uint64_t begin = 0; begin < count; begin += CHUNK_SIZE) {
+            uint64_t end = std::min(count, begin + CHUNK_SIZE);
+            threadPool.submit(group, [&instances, level, begin, end] {
+                std::vector<glm::vec2> offsets(end - begin);
+                SierpinskiLevel::generateOffsets(level, begin, end, offsets.data());
+                for (uint64_t i = begin; i < end; i++) {
+                    instances[i].offset = offsets[i - begin];
+                }
+            });
+        }
+        threadPool.wait(group);
+
+        models.push_back(std::make_shared<LveModel>(lveDevice, uploader, vertices, instances));
     }
+    return models;
 }
 } // namespace lve
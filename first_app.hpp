@@ -1,21 +1,68 @@
 #pragma once
 
+#include "culled_render_system.hpp"
+#include "indirect_render_system.hpp"
 #include "lve_device.hpp"
+#include "lve_frame_readback.hpp"
+#include "lve_parallel_recorder.hpp"
 #include "lve_game_object.hpp"
+#include "lve_mesh_arena.hpp"
+#include "lve_pipeline_builder.hpp"
 #include "lve_renderer.hpp"
+#include "lve_thread_pool.hpp"
 #include "lve_window.hpp"
+#include "simple_render_system.hpp"
 
 #include <chrono>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace lve {
 
+// startup options, filled from the command line in main.cpp
+struct FirstAppConfig {
+    // --gpu-generation: expand the levels with a compute shader instead of on the cpu
+    bool gpuGeneration = false;
+    // --validate-gpu-generation: read the gpu levels back and compare them with the cpu generator
+    bool validateGpuGeneration = false;
+    // --render-mode=vertices|instanced|procedural
+    RenderMode renderMode = RenderMode::Vertices;
+    // --vertex-format=float|packed16|packed32: vertex buffer layout of --render-mode=vertices
+    VertexFormat vertexFormat = VertexFormat::Float;
+    // --indexed: store every shared corner once and draw --render-mode=vertices with an index buffer
+    bool indexed = false;
+    // --max-depth=N: number of levels, 0 keeps FirstApp's default
+    int maxDepth = 0;
+    // --frames-in-flight=N: 1 .. LveSwapChain::MAX_FRAMES_IN_FLIGHT frames recorded ahead of the gpu
+    int framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT;
+    // --headless[=N]: no window, render N frames (300 by default) into an offscreen target and exit
+    bool headless = false;
+    int headlessFrames = 300;
+    // --record=prefix|-: write every frame as <prefix>000000.png ..., or as raw rgba to stdout with "-",
+    // implies --headless
+    std::string recordPath;
+    // --parallel-recording[=N]: record the draws into N >= 1 secondary command buffers on a thread pool,
+    // without N (recordingChunks = 0) one per pool thread; ignored with --indirect and --gpu-culling
+    bool parallelRecording = false;
+    unsigned recordingChunks = 0;
+    // --indirect: per object data in a storage buffer and indirect draws, the cpu cost of a frame no
+    // longer depends on the number of objects; needs the mesh arena, so cpu generated vertices
+    bool indirect = false;
+    // --gpu-culling[=px]: no levels are generated, a compute pass walks the hierarchy every frame, drops
+    // what is off screen and draws sub-triangles smaller than px pixels (1 by default) as one triangle
+    bool gpuCulling = false;
+    float cullThreshold = 1.0f;
+    // --trace=file: record a chrome trace (cpu zones and gpu timestamps), F12 writes what was
+    // recorded since the last write to a numbered file next to it, the rest goes to file at exit
+    std::string tracePath;
+};
+
 class FirstApp {
 public:
     static constexpr int WIDTH = 800;
     static constexpr int HEIGHT = 600;
-    FirstApp();
+    FirstApp(const FirstAppConfig &config = FirstAppConfig{});
     ~FirstApp();
     FirstApp(const FirstApp &) = delete;
     FirstApp &operator=(const FirstApp &) = delete;
@@ -23,14 +70,14 @@ public:
 
 private:
     void loadGameObjects();
+    std::unique_ptr<LveRenderer> createRenderer();
+    std::vector<std::shared_ptr<LveModel>> createGpuLevelModels();
+    // every level as a range of one buffer
+    std::shared_ptr<LveMeshArena> createLevelArena(LveUploader &uploader, std::vector<LveMeshRange> &meshes);
+    std::vector<std::shared_ptr<LveModel>> createInstancedLevelModels(LveUploader &uploader);
     bool isTime();
     void createSier();
-    void sierpinski(
-        std::vector<std::vector<LveModel::Vertex>> &vertices,
-        int depth,
-        glm::vec2 left,
-        glm::vec2 right,
-        glm::vec2 top);
+    FirstAppConfig config;
     float cycle = 0;
     float defaultSize = 1.f;
     float timeDifference = .0f;
@@ -41,9 +88,16 @@ private:
     {glm::vec2(1.0f, 1.0f)},
     {glm::vec2(-1.0f, 1.0f)}
 };
-    LveWindow lveWindow{WIDTH, HEIGHT, "sierpinski"};
-    LveDevice lveDevice{lveWindow};
-    LveRenderer lveRenderer{lveWindow, lveDevice};
+    LveThreadPool threadPool{};
+    // compiles pipeline variants on threadPool's workers
+    LvePipelineBuilder pipelineBuilder{threadPool};
+    // no window (and no glfw at all) when headless
+    std::unique_ptr<LveWindow> lveWindow =
+        config.headless ? nullptr : std::make_unique<LveWindow>(WIDTH, HEIGHT, "sierpinski");
+    LveDevice lveDevice{lveWindow.get()};
+    std::unique_ptr<LveRenderer> lveRenderer = createRenderer();
+    // only when recording
+    std::unique_ptr<LveFrameReadback> frameReadback;
     std::vector<LveGameObject> gameObjects;
 
 };
@@ -0,0 +1,293 @@
+#include "indirect_render_system.hpp"
+#include "shaders/indirect_packed_shader.vert.hpp"
+#include "shaders/indirect_shader.frag.hpp"
+#include "shaders/indirect_shader.vert.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace {
+
+// one per object, std430 layout of ObjectData in indirect_shader.vert
+struct IndirectObjectData {
+    // columns of the mat2
+    glm::vec4 transform;
+    glm::vec4 color;
+    glm::vec2 offset;
+    int32_t level;
+    int32_t padding;
+};
+static_assert(sizeof(IndirectObjectData) == 48, "must match the std430 layout in the shader");
+
+struct IndirectPushConstantData {
+    // added to gl_InstanceIndex, only non zero without drawIndirectFirstInstance
+    uint32_t firstObject;
+};
+
+} // namespace
+
+namespace lve {
+
+IndirectRenderSystem::IndirectRenderSystem(
+    LveDevice& device, VkRenderPass renderPass, int frameSlots, VertexFormat vertexFormat)
+    : lveDevice{device},
+      renderPass{renderPass},
+      vertexFormat{vertexFormat},
+      multiDraw{device.enabledFeatures.multiDrawIndirect == VK_TRUE &&
+                device.enabledFeatures.drawIndirectFirstInstance == VK_TRUE},
+      firstInstance{device.enabledFeatures.drawIndirectFirstInstance == VK_TRUE},
+      pipelines{[this](const bool& blended) { return createPipeline(blended); }},
+      frames(frameSlots) {
+    createDescriptorSetLayout();
+    createPipelineLayout();
+    createDescriptorPool(frameSlots);
+    pipelines.get(false);
+    pipelines.get(true);
+}
+
+IndirectRenderSystem::~IndirectRenderSystem() {
+    for (auto& frame : frames) {
+        destroyBuffers(frame);
+    }
+    // frees the sets as well
+    vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+    vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+}
+
+bool IndirectRenderSystem::canDraw(const std::vector<LveGameObject>& gameObjects) {
+    return std::all_of(gameObjects.begin(), gameObjects.end(), [](const LveGameObject& obj) {
+        return obj.meshArena != nullptr;
+    });
+}
+
+void IndirectRenderSystem::createDescriptorSetLayout() {
+    // binding 0 is the per object storage buffer
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout");
+    }
+}
+
+void IndirectRenderSystem::createPipelineLayout() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(IndirectPushConstantData);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout");
+    }
+}
+
+void IndirectRenderSystem::createDescriptorPool(int frameSlots) {
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = static_cast<uint32_t>(frameSlots);
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = static_cast<uint32_t>(frameSlots);
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool");
+    }
+
+    std::vector<VkDescriptorSetLayout> setLayouts(frameSlots, descriptorSetLayout);
+    std::vector<VkDescriptorSet> descriptorSets(frameSlots);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = static_cast<uint32_t>(frameSlots);
+    allocInfo.pSetLayouts = setLayouts.data();
+    if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor sets");
+    }
+    for (int slot = 0; slot < frameSlots; slot++) {
+        frames[slot].descriptorSet = descriptorSets[slot];
+    }
+}
+
+std::unique_ptr<LvePipeline> IndirectRenderSystem::createPipeline(bool blended) {
+    assert(pipelineLayout != nullptr && "cannot create pipeline before pipeline layout");
+    PipelineConfigInfo pipelineConfig{};
+    LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
+    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.pipelineLayout = pipelineLayout;
+
+    // indirect_shader.frag: constant_id 0 = BLENDED
+    pipelineConfig.colorBlendAttachment.blendEnable = blended ? VK_TRUE : VK_FALSE;
+    pipelineConfig.fragSpecialization.set(0, blended);
+
+    pipelineConfig.bindingDescriptions = LveModel::getBindingDescription(vertexFormat);
+    pipelineConfig.attributeDescriptions = LveModel::getAttributeDescription(vertexFormat);
+    SpirvSpan vertCode = shaders::indirect_shader_vert;
+    if (vertexFormat != VertexFormat::Float) {
+        vertCode = shaders::indirect_packed_shader_vert;
+        // indirect_packed_shader.vert: constant_id 0 = POSITION_SCALE
+        pipelineConfig.vertSpecialization.set(0, LveModel::positionScale(vertexFormat));
+    }
+
+    return std::make_unique<LvePipeline>(lveDevice, vertCode, shaders::indirect_shader_frag, pipelineConfig);
+}
+
+VkDeviceSize IndirectRenderSystem::indexedCommandOffset(const Frame& frame) const {
+    return sizeof(VkDrawIndirectCommand) * frame.capacity;
+}
+
+void IndirectRenderSystem::reserve(Frame& frame, uint32_t objectCount) {
+    if (objectCount <= frame.capacity) {
+        return;
+    }
+    // the slot's last frame is done, nothing on the gpu uses the old buffers anymore
+    destroyBuffers(frame);
+    frame.capacity = std::max<uint32_t>(64, objectCount + objectCount / 2);
+
+    lveDevice.createBuffer(
+        sizeof(IndirectObjectData) * frame.capacity,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        frame.objectBuffer,
+        frame.objectMemory);
+    // room for every object in either array, the arenas decide which one it ends up in
+    lveDevice.createBuffer(
+        (sizeof(VkDrawIndirectCommand) + sizeof(VkDrawIndexedIndirectCommand)) * frame.capacity,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        frame.commandBuffer,
+        frame.commandMemory);
+
+    VkDescriptorBufferInfo bufferInfo{frame.objectBuffer, 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = frame.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(lveDevice.device(), 1, &write, 0, nullptr);
+}
+
+void IndirectRenderSystem::destroyBuffers(Frame& frame) {
+    if (frame.objectBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(lveDevice.device(), frame.objectBuffer, nullptr);
+        lveDevice.allocator().free(frame.objectMemory);
+        frame.objectBuffer = VK_NULL_HANDLE;
+    }
+    if (frame.commandBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(lveDevice.device(), frame.commandBuffer, nullptr);
+        lveDevice.allocator().free(frame.commandMemory);
+        frame.commandBuffer = VK_NULL_HANDLE;
+    }
+}
+
+void IndirectRenderSystem::renderGameObjects(
+    VkCommandBuffer commandBuffer, int frameSlot, const std::vector<LveGameObject>& gameObjects, LveGpuProfiler* profiler){
+    assert(canDraw(gameObjects) && "every object needs a mesh arena");
+    if (gameObjects.empty()) {
+        return;
+    }
+    Frame& frame = frames[frameSlot];
+    reserve(frame, static_cast<uint32_t>(gameObjects.size()));
+
+    // host coherent, the writes are visible to the gpu once the frame is submitted
+    auto* objects = static_cast<IndirectObjectData*>(frame.objectMemory.mapped);
+    auto* drawCommands = static_cast<VkDrawIndirectCommand*>(frame.commandMemory.mapped);
+    auto* indexedCommands = reinterpret_cast<VkDrawIndexedIndirectCommand*>(
+        static_cast<char*>(frame.commandMemory.mapped) + indexedCommandOffset(frame));
+    uint32_t drawCount = 0;
+    uint32_t indexedCount = 0;
+    runs.clear();
+    for (uint32_t i = 0; i < gameObjects.size(); i++) {
+        const auto& obj = gameObjects[i];
+        glm::mat2 transform = obj.transform2d.mat2();
+        objects[i].transform = {transform[0], transform[1]};
+        objects[i].color = {obj.color, obj.alpha};
+        objects[i].offset = obj.transform2d.translation;
+        objects[i].level = obj.depth;
+
+        // gl_InstanceIndex = firstInstance, or 0 plus the pushed index
+        uint32_t instance = firstInstance ? i : 0;
+        const LveMeshRange& mesh = obj.mesh;
+        bool indexed = mesh.indexCount > 0;
+        uint32_t command = indexed ? indexedCount++ : drawCount++;
+        if (indexed) {
+            indexedCommands[command] = {mesh.indexCount, 1, mesh.firstIndex, static_cast<int32_t>(mesh.firstVertex), instance};
+        } else {
+            drawCommands[command] = {mesh.vertexCount, 1, mesh.firstVertex, instance};
+        }
+
+        LvePipeline* pipeline = &pipelines.get(obj.alpha < 1.0f);
+        const LveMeshArena* arena = obj.meshArena.get();
+        if (runs.empty() || runs.back().pipeline != pipeline || runs.back().arena != arena ||
+            runs.back().indexed != indexed || runs.back().count == lveDevice.properties.limits.maxDrawIndirectCount) {
+            runs.push_back({pipeline, arena, indexed, command, i, 0});
+        }
+        runs.back().count++;
+    }
+
+    uint32_t scope = profiler ? profiler->beginScope(commandBuffer, "indirect draws") : UINT32_MAX;
+    vkCmdBindDescriptorSets(
+        commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+    IndirectPushConstantData push{0};
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+
+    LvePipeline* boundPipeline = nullptr;
+    const LveMeshArena* boundArena = nullptr;
+    for (const Run& run : runs) {
+        if (run.pipeline != boundPipeline) {
+            run.pipeline->bind(commandBuffer);
+            boundPipeline = run.pipeline;
+        }
+        if (run.arena != boundArena) {
+            run.arena->bind(commandBuffer);
+            boundArena = run.arena;
+        }
+        VkDeviceSize stride = run.indexed ? sizeof(VkDrawIndexedIndirectCommand) : sizeof(VkDrawIndirectCommand);
+        VkDeviceSize offset = (run.indexed ? indexedCommandOffset(frame) : 0) + stride * run.firstCommand;
+        // without multiDrawIndirect drawCount has to be 1
+        uint32_t callCount = multiDraw ? 1 : run.count;
+        uint32_t commandsPerCall = multiDraw ? run.count : 1;
+        for (uint32_t call = 0; call < callCount; call++) {
+            if (!firstInstance) {
+                push.firstObject = run.firstObject + call;
+                vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(push), &push);
+            }
+            if (run.indexed) {
+                vkCmdDrawIndexedIndirect(
+                    commandBuffer, frame.commandBuffer, offset + stride * call, commandsPerCall, static_cast<uint32_t>(stride));
+            } else {
+                vkCmdDrawIndirect(
+                    commandBuffer, frame.commandBuffer, offset + stride * call, commandsPerCall, static_cast<uint32_t>(stride));
+            }
+        }
+    }
+    if (profiler) {
+        profiler->endScope(commandBuffer, scope);
+    }
+}
+
+} // namespace lve
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_game_object.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_mesh_arena.hpp"
+#include "lve_pipeline.hpp"
+#include "lve_pipeline_builder.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+    // Draws game objects whose meshes live in an LveMeshArena without any per object commands.
+    // Every frame the transform, offset, color and alpha of each object go into a storage buffer
+    // and one VkDraw(Indexed)IndirectCommand per object into an indirect buffer, both host visible
+    // and one set per frame slot. The objects are then drawn with one vkCmdDraw(Indexed)Indirect
+    // per run of objects sharing pipeline and arena, which is one or two calls for the fractal levels,
+    // and the vertex shader finds its object through gl_InstanceIndex (firstInstance = object index).
+    // Without multiDrawIndirect every command gets its own vkCmdDrawIndirect, without
+    // drawIndirectFirstInstance the object index is pushed before each of them instead.
+    class IndirectRenderSystem {
+        public:
+        IndirectRenderSystem(
+            LveDevice& device,
+            VkRenderPass renderPass,
+            int frameSlots,
+            VertexFormat vertexFormat = VertexFormat::Float);
+        ~IndirectRenderSystem();
+        IndirectRenderSystem(const IndirectRenderSystem&) = delete;
+        IndirectRenderSystem& operator=(const IndirectRenderSystem&) = delete;
+
+        // only objects with a mesh arena can be drawn indirectly
+        static bool canDraw(const std::vector<LveGameObject>& gameObjects);
+
+        // frameSlot's previous frame has to be finished (LveRenderer::beginFrame waits for it)
+        void renderGameObjects(
+            VkCommandBuffer commandBuffer,
+            int frameSlot,
+            const std::vector<LveGameObject>& gameObjects,
+            LveGpuProfiler* profiler = nullptr);
+
+        // false when the device lacks multiDrawIndirect or drawIndirectFirstInstance
+        bool usesMultiDraw() const { return multiDraw; }
+
+    private:
+        struct Frame {
+            VkBuffer objectBuffer = VK_NULL_HANDLE;
+            LveAllocation objectMemory{};
+            // the plain commands first, the indexed ones after them
+            VkBuffer commandBuffer = VK_NULL_HANDLE;
+            LveAllocation commandMemory{};
+            uint32_t capacity = 0;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        };
+
+        // consecutive objects drawn with one call
+        struct Run {
+            LvePipeline* pipeline;
+            const LveMeshArena* arena;
+            bool indexed;
+            // first command in the plain or indexed array
+            uint32_t firstCommand;
+            uint32_t firstObject;
+            uint32_t count;
+        };
+
+        void createDescriptorSetLayout();
+        void createPipelineLayout();
+        void createDescriptorPool(int frameSlots);
+        std::unique_ptr<LvePipeline> createPipeline(bool blended);
+        void reserve(Frame& frame, uint32_t objectCount);
+        void destroyBuffers(Frame& frame);
+        VkDeviceSize indexedCommandOffset(const Frame& frame) const;
+
+        LveDevice& lveDevice;
+        VkRenderPass renderPass;
+        VertexFormat vertexFormat;
+        bool multiDraw;
+        bool firstInstance;
+
+        VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        // keyed by blended, like SimpleRenderSystem only the fading object needs blending
+        LvePipelineVariants<bool> pipelines;
+        std::vector<Frame> frames;
+        std::vector<Run> runs;
+    };
+}
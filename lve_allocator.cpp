@@ -0,0 +1,190 @@
+#include "lve_allocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+LveAllocator::LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize)
+    : device{device}, blockSize{blockSize} {
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+}
+
+LveAllocator::~LveAllocator() {
+    assert(allocationCount == 0 && "every allocation has to be freed before the allocator");
+    for (auto &block : blocks) {
+        if (block->mapped != nullptr) {
+            vkUnmapMemory(device, block->memory);
+        }
+        vkFreeMemory(device, block->memory, nullptr);
+    }
+}
+
+LveAllocation LveAllocator::allocate(
+    const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, ResourceKind kind) {
+    std::lock_guard<std::mutex> lock{mutex};
+    LveAllocation allocation{};
+
+    // small heaps (integrated gpus, the 256 MiB BAR heap) get smaller blocks
+    uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    VkDeviceSize typeBlockSize = std::min(blockSize, memoryProperties.memoryHeaps[heapIndex].size / 8);
+
+    if (requirements.size > typeBlockSize / 2) {
+        Block *block = createBlock(requirements.size, memoryTypeIndex, kind, true);
+        allocateFromBlock(*block, requirements, allocation);
+    } else {
+        bool found = false;
+        for (auto &block : blocks) {
+            if (!block->dedicated && block->memoryTypeIndex == memoryTypeIndex && block->kind == kind &&
+                allocateFromBlock(*block, requirements, allocation)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            Block *block = createBlock(typeBlockSize, memoryTypeIndex, kind, false);
+            allocateFromBlock(*block, requirements, allocation);
+        }
+    }
+
+    liveBytes += allocation.size;
+    allocationCount++;
+    return allocation;
+}
+
+void LveAllocator::free(LveAllocation &allocation) {
+    if (allocation.block == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock{mutex};
+    Block *block = static_cast<Block *>(allocation.block);
+
+    auto next = block->freeRanges.emplace(allocation.offset, allocation.size).first;
+    // merge with the free range after and before this one
+    auto after = std::next(next);
+    if (after != block->freeRanges.end() && next->first + next->second == after->first) {
+        next->second += after->second;
+        block->freeRanges.erase(after);
+    }
+    if (next != block->freeRanges.begin()) {
+        auto before = std::prev(next);
+        if (before->first + before->second == next->first) {
+            before->second += next->second;
+            block->freeRanges.erase(next);
+        }
+    }
+
+    liveBytes -= allocation.size;
+    allocationCount--;
+    block->allocationCount--;
+    if (block->allocationCount == 0) {
+        destroyBlock(block);
+    }
+    allocation = LveAllocation{};
+}
+
+LveAllocator::Stats LveAllocator::stats() {
+    std::lock_guard<std::mutex> lock{mutex};
+    Stats stats{};
+    stats.liveBytes = liveBytes;
+    stats.allocationCount = allocationCount;
+    stats.blockCount = static_cast<uint32_t>(blocks.size());
+    stats.peakReservedBytes = peakReservedBytes;
+
+    VkDeviceSize freeBytes = 0;
+    for (auto &block : blocks) {
+        stats.reservedBytes += block->size;
+        for (auto &range : block->freeRanges) {
+            freeBytes += range.second;
+            stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+        }
+    }
+    if (freeBytes > 0) {
+        stats.fragmentation = 1.0f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(freeBytes);
+    }
+    return stats;
+}
+
+void LveAllocator::resetPeak() {
+    std::lock_guard<std::mutex> lock{mutex};
+    peakReservedBytes = reservedBytes;
+}
+
+LveAllocator::Block *LveAllocator::createBlock(
+    VkDeviceSize size, uint32_t memoryTypeIndex, ResourceKind kind, bool dedicated) {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    auto block = std::make_unique<Block>();
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate device memory block!");
+    }
+    block->size = size;
+    block->memoryTypeIndex = memoryTypeIndex;
+    block->kind = kind;
+    block->dedicated = dedicated;
+    block->freeRanges.emplace(0, size);
+
+    if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+            vkFreeMemory(device, block->memory, nullptr);
+            throw std::runtime_error("failed to map device memory block!");
+        }
+    }
+
+    reservedBytes += size;
+    peakReservedBytes = std::max(peakReservedBytes, reservedBytes);
+    blocks.push_back(std::move(block));
+    return blocks.back().get();
+}
+
+void LveAllocator::destroyBlock(Block *block) {
+    if (block->mapped != nullptr) {
+        vkUnmapMemory(device, block->memory);
+    }
+    vkFreeMemory(device, block->memory, nullptr);
+    reservedBytes -= block->size;
+    blocks.erase(std::find_if(blocks.begin(), blocks.end(), [block](auto &b) { return b.get() == block; }));
+}
+
+bool LveAllocator::allocateFromBlock(
+    Block &block, const VkMemoryRequirements &requirements, LveAllocation &allocation) {
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    for (auto range = block.freeRanges.begin(); range != block.freeRanges.end(); ++range) {
+        VkDeviceSize rangeBegin = range->first;
+        VkDeviceSize rangeEnd = range->first + range->second;
+        VkDeviceSize offset = alignUp(rangeBegin, alignment);
+        if (offset + requirements.size > rangeEnd) {
+            continue;
+        }
+
+        // the alignment padding in front stays free, so does the rest behind the allocation
+        block.freeRanges.erase(range);
+        if (offset > rangeBegin) {
+            block.freeRanges.emplace(rangeBegin, offset - rangeBegin);
+        }
+        if (offset + requirements.size < rangeEnd) {
+            block.freeRanges.emplace(offset + requirements.size, rangeEnd - offset - requirements.size);
+        }
+
+        allocation.memory = block.memory;
+        allocation.offset = offset;
+        allocation.size = requirements.size;
+        allocation.mapped = block.mapped != nullptr ? static_cast<char *>(block.mapped) + offset : nullptr;
+        allocation.block = &block;
+        block.allocationCount++;
+        return true;
+    }
+    return false;
+}
+
+} // namespace lve
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve {
+
+class LveAllocator;
+
+// A piece of a VkDeviceMemory block. Bind the resource at (memory, offset).
+struct LveAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    // host address of the allocation for HOST_VISIBLE memory, the blocks stay mapped because
+    // vulkan doesn't allow mapping the same VkDeviceMemory twice
+    void *mapped = nullptr;
+
+private:
+    friend class LveAllocator;
+    void *block = nullptr;
+};
+
+// Sub-allocates buffers and images out of big VkDeviceMemory blocks, so a scene with many models
+// needs a handful of vkAllocateMemory calls instead of one per object (maxMemoryAllocationCount
+// can be as low as 4096).
+// Every block belongs to one memory type and keeps a free list sorted by offset: allocation is
+// first fit with the resource alignment, freeing merges the range with its free neighbours.
+// Buffers and optimal tiling images never share a block, that way two neighbouring resources are
+// always the same kind and bufferImageGranularity never applies.
+// Anything bigger than half a block gets its own dedicated VkDeviceMemory.
+class LveAllocator {
+public:
+    enum class ResourceKind { Linear, Optimal };
+
+    struct Stats {
+        VkDeviceSize liveBytes = 0;       // bytes handed out to resources
+        VkDeviceSize reservedBytes = 0;   // bytes allocated from the driver
+        VkDeviceSize peakReservedBytes = 0; // most reservedBytes since creation or resetPeak()
+        VkDeviceSize largestFreeRange = 0;
+        uint32_t allocationCount = 0;
+        uint32_t blockCount = 0;          // vkAllocateMemory calls currently alive
+        // 0 when all free space of the blocks is one range, close to 1 when it is split in many small ranges
+        float fragmentation = 0.0f;
+    };
+
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+    LveAllocator(VkPhysicalDevice physicalDevice, VkDevice device, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+    ~LveAllocator();
+    LveAllocator(const LveAllocator &) = delete;
+    LveAllocator &operator=(const LveAllocator &) = delete;
+
+    LveAllocation allocate(
+        const VkMemoryRequirements &requirements, uint32_t memoryTypeIndex, ResourceKind kind);
+    // resets the allocation, freeing an empty allocation does nothing
+    void free(LveAllocation &allocation);
+
+    Stats stats();
+    // starts a new high water mark at the current reservedBytes
+    void resetPeak();
+
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeIndex = 0;
+        ResourceKind kind = ResourceKind::Linear;
+        bool dedicated = false;
+        void *mapped = nullptr;
+        uint32_t allocationCount = 0;
+        // offset -> size of every free range
+        std::map<VkDeviceSize, VkDeviceSize> freeRanges;
+    };
+
+    Block *createBlock(VkDeviceSize size, uint32_t memoryTypeIndex, ResourceKind kind, bool dedicated);
+    void destroyBlock(Block *block);
+    bool allocateFromBlock(Block &block, const VkMemoryRequirements &requirements, LveAllocation &allocation);
+
+    VkDevice device;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    VkDeviceSize blockSize;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Block>> blocks;
+    VkDeviceSize liveBytes = 0;
+    VkDeviceSize reservedBytes = 0;
+    VkDeviceSize peakReservedBytes = 0;
+    uint32_t allocationCount = 0;
+};
+
+} // namespace lve
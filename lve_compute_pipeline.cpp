@@ -0,0 +1,46 @@
+#include "lve_compute_pipeline.hpp"
+
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+LveComputePipeline::LveComputePipeline(LveDevice &device, SpirvSpan compCode, VkPipelineLayout pipelineLayout)
+    : lveDevice{device} {
+    createComputePipeline(compCode, pipelineLayout);
+}
+
+LveComputePipeline::~LveComputePipeline() {
+    vkDestroyShaderModule(lveDevice.device(), compShaderModule, nullptr);
+    vkDestroyPipeline(lveDevice.device(), computePipeline, nullptr);
+}
+
+void LveComputePipeline::createComputePipeline(SpirvSpan compCode, VkPipelineLayout pipelineLayout) {
+    assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline:: no pipelineLayout provided");
+    LvePipeline::createShaderModule(lveDevice, compCode, &compShaderModule);
+
+    VkPipelineShaderStageCreateInfo shaderStage{};
+    shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStage.module = compShaderModule;
+    shaderStage.pName = "main";
+    shaderStage.pSpecializationInfo = nullptr;
+
+    // a compute pipeline has no fixed function state, only the shader and the layout
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = shaderStage;
+    pipelineInfo.layout = pipelineLayout;
+    pipelineInfo.basePipelineIndex = -1;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    if (vkCreateComputePipelines(lveDevice.device(), lveDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline");
+    }
+}
+
+void LveComputePipeline::bind(VkCommandBuffer commandBuffer) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+}
+
+} // namespace lve
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_pipeline.hpp"
+
+namespace lve
+{
+    // Compute counterpart of LvePipeline: one compute shader stage and a pipeline layout,
+    // bound to VK_PIPELINE_BIND_POINT_COMPUTE.
+    class LveComputePipeline
+    {
+    public:
+        LveComputePipeline(LveDevice &device, SpirvSpan compCode, VkPipelineLayout pipelineLayout);
+
+        ~LveComputePipeline();
+        LveComputePipeline(const LveComputePipeline &) = delete;
+        LveComputePipeline &operator=(const LveComputePipeline &) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        void createComputePipeline(SpirvSpan compCode, VkPipelineLayout pipelineLayout);
+
+        LveDevice &lveDevice;
+        VkPipeline computePipeline;
+        VkShaderModule compShaderModule;
+    };
+} // namespace lve
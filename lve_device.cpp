@@ -78,7 +78,9 @@ namespace lve
     }
   }
   // class member functions
-  LveDevice::LveDevice(LveWindow &window) : window{window}
+  LveDevice::LveDevice(LveWindow &window) : LveDevice(&window) {}
+
+  LveDevice::LveDevice(LveWindow *window) : window{window}
   {
     //checkExtention();
     createInstance();      // -> vulkan instance
@@ -86,12 +88,16 @@ namespace lve
     createSurface();       // connection between vulkan and window
     pickPhysicalDevice();  // pick the best gpu (maybe?)
     createLogicalDevice(); // create logical device to interface with physical device
+    allocator_ = std::make_unique<LveAllocator>(physicalDevice, device_); // sub-allocates buffer and image memory
+    pipelineCache_ = std::make_unique<LvePipelineCache>(device_, properties); // loads the last run's pipelines
     createCommandPool();   // comment buffer allocation
   }
 
   LveDevice::~LveDevice()
   {
     vkDestroyCommandPool(device_, commandPool, nullptr);
+    allocator_.reset();
+    pipelineCache_.reset(); // written to disk here
     vkDestroyDevice(device_, nullptr);
 
     if (enableValidationLayers)
@@ -99,7 +105,10 @@ namespace lve
       DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
     }
 
-    vkDestroySurfaceKHR(instance, surface_, nullptr);
+    if (surface_ != VK_NULL_HANDLE)
+    {
+      vkDestroySurfaceKHR(instance, surface_, nullptr);
+    }
     vkDestroyInstance(instance, nullptr);
   }
 
@@ -120,12 +129,18 @@ namespace lve
 
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-    createInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR; // for macos support
     createInfo.pApplicationInfo = &appInfo;
 
     auto extensions = getRequiredExtensions();
-    extensions.push_back("VK_KHR_portability_enumeration"); // for macos support
-    extensions.push_back("VK_KHR_get_physical_device_properties2"); 
+    if (hasInstanceExtension(portabilityEnumerationExtension))
+    {
+      createInfo.flags = VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR; // for macos support
+      extensions.push_back(portabilityEnumerationExtension);
+    }
+    if (hasInstanceExtension("VK_KHR_get_physical_device_properties2"))
+    {
+      extensions.push_back("VK_KHR_get_physical_device_properties2");
+    }
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -200,8 +215,14 @@ namespace lve
       queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
     VkPhysicalDeviceFeatures deviceFeatures = {};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // optional, IndirectRenderSystem falls back when they are missing
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    enabledFeatures = deviceFeatures;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -209,9 +230,20 @@ namespace lve
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+    // the spec requires portability_subset to be enabled whenever the device exposes it
+    std::vector<const char *> enabledExtensions;
+    if (!isHeadless())
+    {
+      enabledExtensions = deviceExtensions;
+    }
+    if (hasDeviceExtension(physicalDevice, portabilitySubsetExtension))
+    {
+      enabledExtensions.push_back(portabilitySubsetExtension);
+    }
+
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -250,7 +282,15 @@ namespace lve
     }
   }
 
-  void LveDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+  void LveDevice::createSurface()
+  {
+    if (isHeadless())
+    {
+      surface_ = VK_NULL_HANDLE;
+      return;
+    }
+    window->createWindowSurface(instance, &surface_);
+  }
 
   bool LveDevice::isDeviceSuitable(VkPhysicalDevice device)
   {
@@ -258,8 +298,8 @@ namespace lve
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported)
+    bool swapChainAdequate = isHeadless();
+    if (extensionsSupported && !isHeadless())
     {
       SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
       swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
@@ -330,11 +370,15 @@ namespace lve
 
   std::vector<const char *> LveDevice::getRequiredExtensions()
   {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char *> extensions;
+    // headless runs never initialize glfw and don't need the surface extensions
+    if (!isHeadless())
+    {
+      uint32_t glfwExtensionCount = 0;
+      const char **glfwExtensions;
+      glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+      extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers)
     {
@@ -384,6 +428,11 @@ namespace lve
         availableExtensions.data());
 
     std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    if (isHeadless())
+    {
+      // nothing is presented, so the swap chain extension isn't needed
+      requiredExtensions.clear();
+    }
 
     for (const auto &extension : availableExtensions)
     {
@@ -393,6 +442,40 @@ namespace lve
     return requiredExtensions.empty();
   }
 
+  bool LveDevice::hasInstanceExtension(const char *name)
+  {
+    uint32_t extensionCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+    for (const auto &extension : extensions)
+    {
+      if (strcmp(extension.extensionName, name) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool LveDevice::hasDeviceExtension(VkPhysicalDevice device, const char *name)
+  {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+    for (const auto &extension : extensions)
+    {
+      if (strcmp(extension.extensionName, name) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
   QueueFamilyIndices LveDevice::findQueueFamilies(VkPhysicalDevice device)
   {
     QueueFamilyIndices indices;
@@ -406,13 +489,23 @@ namespace lve
     int i = 0;
     for (const auto &queueFamily : queueFamilies)
     {
-      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+      // the graphics queue also runs the compute passes, so it has to support both
+      if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+          (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT))
       {
         indices.graphicsFamily = i;
         indices.graphicsFamilyHasValue = true;
       }
       VkBool32 presentSupport = false;
-      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      if (isHeadless())
+      {
+        // nothing to present to, the graphics queue doubles as present queue
+        presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+      }
+      else
+      {
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      }
       if (queueFamily.queueCount > 0 && presentSupport)
       {
         indices.presentFamily = i;
@@ -495,12 +588,21 @@ namespace lve
     throw std::runtime_error("failed to find suitable memory type!");
   }
 
+  uint32_t LveDevice::graphicsTimestampValidBits()
+  {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    return queueFamilies[findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+  }
+
   void LveDevice::createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory)
+      LveAllocation &bufferMemory)
   {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -516,17 +618,12 @@ namespace lve
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to allocate vertex buffer memory!");
-    }
+    bufferMemory = allocator_->allocate(
+        memRequirements,
+        findMemoryType(memRequirements.memoryTypeBits, properties),
+        LveAllocator::ResourceKind::Linear);
 
-    vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
   }
 
   VkCommandBuffer LveDevice::beginSingleTimeCommands()
@@ -608,7 +705,7 @@ namespace lve
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory)
+      LveAllocation &imageMemory)
   {
     if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS)
     {
@@ -618,17 +715,15 @@ namespace lve
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS)
-    {
-      throw std::runtime_error("failed to allocate image memory!");
-    }
+    // linear tiling images are laid out like buffers, everything else has to stay
+    // bufferImageGranularity away from buffers, which separate blocks take care of
+    imageMemory = allocator_->allocate(
+        memRequirements,
+        findMemoryType(memRequirements.memoryTypeBits, properties),
+        imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? LveAllocator::ResourceKind::Linear
+                                                   : LveAllocator::ResourceKind::Optimal);
 
-    if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS)
+    if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS)
     {
       throw std::runtime_error("failed to bind image memory!");
     }
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "lve_allocator.hpp"
+#include "lve_pipeline_cache.hpp"
 #include "lve_window.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -31,6 +34,9 @@ class LveDevice {
 #endif
 
   LveDevice(LveWindow &window);
+  // window == nullptr creates a headless device: no surface, no VK_KHR_swapchain,
+  // only offscreen render targets (see LveOffscreenTarget)
+  explicit LveDevice(LveWindow *window);
   ~LveDevice();
 
   // Not copyable or movable
@@ -42,12 +48,19 @@ class LveDevice {
   VkCommandPool getCommandPool() { return commandPool; }
   VkDevice device() { return device_; }
   VkSurfaceKHR surface() { return surface_; }
+  bool isHeadless() const { return window == nullptr; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  // every buffer and image memory comes from here, free it with allocator().free()
+  LveAllocator &allocator() { return *allocator_; }
+  // persistent across runs, pass it to every vkCreate*Pipelines call
+  VkPipelineCache pipelineCache() { return pipelineCache_->handle(); }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
+  // bits of a timestamp the graphics queue actually writes, 0 when it can't write any
+  uint32_t graphicsTimestampValidBits();
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
@@ -57,7 +70,7 @@ class LveDevice {
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LveAllocation &bufferMemory);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -68,9 +81,12 @@ class LveDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LveAllocation &imageMemory);
 
   VkPhysicalDeviceProperties properties;
+  // what createLogicalDevice turned on: samplerAnisotropy plus the optional features the gpu has
+  // (multiDrawIndirect, drawIndirectFirstInstance), check these before relying on one
+  VkPhysicalDeviceFeatures enabledFeatures{};
 
  private:
   void checkExtention();
@@ -89,21 +105,28 @@ class LveDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  bool hasInstanceExtension(const char *name);
+  bool hasDeviceExtension(VkPhysicalDevice device, const char *name);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  LveWindow &window;
+  LveWindow *window;
   VkCommandPool commandPool;
 
   VkDevice device_;
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  std::unique_ptr<LveAllocator> allocator_;
+  std::unique_ptr<LvePipelineCache> pipelineCache_;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, "VK_KHR_portability_subset"};
+  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  // MoltenVK needs these, software drivers like lavapipe don't have them, so they are only enabled when present
+  const char *portabilitySubsetExtension = "VK_KHR_portability_subset";
+  const char *portabilityEnumerationExtension = "VK_KHR_portability_enumeration";
 };
 
 }  // namespace lve
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "lve_frame_readback.hpp"
+#include "lve_png.hpp"
+#include "lve_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace lve {
+
+LveFrameReadback::Sink LveFrameReadback::rawSink(std::FILE *file) {
+    return [file](const Frame &frame) {
+        if (std::fwrite(frame.rgba.data(), 1, frame.rgba.size(), file) != frame.rgba.size()) {
+            throw std::runtime_error("failed to write raw frame " + std::to_string(frame.number));
+        }
+        std::fflush(file);
+    };
+}
+
+LveFrameReadback::Sink LveFrameReadback::pngSequenceSink(const std::string &prefix) {
+    return [prefix](const Frame &frame) {
+        std::ostringstream path;
+        path << prefix << std::setw(6) << std::setfill('0') << frame.number << ".png";
+        LvePngWriter::write(path.str(), frame.width, frame.height, frame.rgba.data());
+    };
+}
+
+LveFrameReadback::LveFrameReadback(
+    LveDevice &device, VkExtent2D extent, int frameSlots, Sink sink, size_t queueDepth)
+    : lveDevice{device},
+      extent{extent},
+      frameSize{static_cast<VkDeviceSize>(extent.width) * extent.height * 4},
+      sink{std::move(sink)},
+      queueDepth{std::max<size_t>(queueDepth, 1)} {
+    slots.resize(frameSlots);
+    try {
+        for (auto &slot : slots) {
+            // the cpu reads every byte, cached memory makes that a lot faster where the device has it
+            try {
+                lveDevice.createBuffer(
+                    frameSize,
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT |
+                        VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                    slot.buffer,
+                    slot.memory);
+            } catch (const std::runtime_error &) {
+                // createBuffer looks for the memory type after creating the buffer
+                vkDestroyBuffer(lveDevice.device(), slot.buffer, nullptr);
+                slot.buffer = VK_NULL_HANDLE;
+                lveDevice.createBuffer(
+                    frameSize,
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    slot.buffer,
+                    slot.memory);
+            }
+        }
+    } catch (...) {
+        // the destructor doesn't run for a constructor that throws
+        destroySlots();
+        throw;
+    }
+    encoder = std::thread{[this] { encoderLoop(); }};
+}
+
+LveFrameReadback::~LveFrameReadback() {
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    frameQueued.notify_all();
+    if (encoder.joinable()) {
+        encoder.join();
+    }
+    destroySlots();
+}
+
+void LveFrameReadback::destroySlots() {
+    for (auto &slot : slots) {
+        vkDestroyBuffer(lveDevice.device(), slot.buffer, nullptr);
+        lveDevice.allocator().free(slot.memory);
+        slot.buffer = VK_NULL_HANDLE;
+    }
+}
+
+void LveFrameReadback::readFrame(VkCommandBuffer commandBuffer, int frameSlot, VkImage image) {
+    rethrowEncoderError();
+    Slot &slot = slots[frameSlot];
+    collect(slot);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0; // tightly packed
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = {extent.width, extent.height, 1};
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+    // makes the copy visible to the host once the frame's fence has signaled
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = slot.buffer;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT,
+        0,
+        0,
+        nullptr,
+        1,
+        &barrier,
+        0,
+        nullptr);
+
+    slot.pending = true;
+    slot.frame = nextFrame++;
+}
+
+void LveFrameReadback::collect(Slot &slot) {
+    if (!slot.pending) {
+        return;
+    }
+    LveTraceZone zone{"readback"};
+    std::vector<uint8_t> pixels;
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        if (queue.size() >= queueDepth) {
+            auto waitStart = std::chrono::steady_clock::now();
+            LveTraceZone waitZone{"wait encoder"};
+            frameDone.wait(lock, [this] { return queue.size() < queueDepth || encoderError; });
+            stallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+        }
+        if (!freeFrames.empty()) {
+            pixels = std::move(freeFrames.back());
+            freeFrames.pop_back();
+        }
+    }
+    pixels.resize(frameSize);
+    std::memcpy(pixels.data(), slot.memory.mapped, frameSize);
+    slot.pending = false;
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        queue.push_back({slot.frame, extent.width, extent.height, std::move(pixels)});
+    }
+    frameQueued.notify_one();
+}
+
+void LveFrameReadback::finish() {
+    // the slots hold up to frameSlots frames, oldest first
+    std::vector<Slot *> pending;
+    for (auto &slot : slots) {
+        if (slot.pending) {
+            pending.push_back(&slot);
+        }
+    }
+    std::sort(pending.begin(), pending.end(), [](const Slot *a, const Slot *b) { return a->frame < b->frame; });
+    for (Slot *slot : pending) {
+        collect(*slot);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        frameDone.wait(lock, [this] { return queue.empty() || encoderError; });
+    }
+    rethrowEncoderError();
+}
+
+void LveFrameReadback::encoderLoop() {
+    LveTrace::setThreadName("encoder");
+    std::unique_lock<std::mutex> lock{mutex};
+    while (true) {
+        frameQueued.wait(lock, [this] { return !queue.empty() || stopping; });
+        if (queue.empty()) {
+            return;
+        }
+        Frame frame = std::move(queue.front());
+        bool failed = encoderError != nullptr;
+        lock.unlock();
+
+        // after an error the remaining frames are dropped, the render thread rethrows it
+        std::exception_ptr error;
+        if (!failed) {
+            try {
+                LveTraceZone zone{"encode frame"};
+                sink(frame);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+
+        lock.lock();
+        queue.pop_front();
+        freeFrames.push_back(std::move(frame.rgba));
+        if (error) {
+            encoderError = error;
+        } else if (!failed) {
+            written++;
+        }
+        frameDone.notify_all();
+    }
+}
+
+void LveFrameReadback::rethrowEncoderError() {
+    std::lock_guard<std::mutex> lock{mutex};
+    if (encoderError && !errorRethrown) {
+        errorRethrown = true;
+        std::rethrow_exception(encoderError);
+    }
+}
+
+uint64_t LveFrameReadback::framesWritten() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return written;
+}
+
+double LveFrameReadback::takeStallTime() {
+    double time = stallTime;
+    stallTime = 0.0;
+    return time;
+}
+
+} // namespace lve
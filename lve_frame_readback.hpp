@@ -0,0 +1,102 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std lib headers
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+// Copies every rendered frame back to the cpu without stalling the gpu.
+// Every frame slot (frame in flight) owns a host visible buffer. readFrame() records a copy of the
+// frame's color image into the slot's buffer at the end of the frame. The next time the slot is used
+// the renderer has already waited for its fence, so readFrame() first takes the bytes of the slot's
+// previous frame out of the mapped buffer and queues them for a background encoder thread.
+// The cpu never waits for the gpu on behalf of the readback, it only waits when the encoder falls
+// more than queueDepth frames behind, that time is reported by takeStallTime().
+class LveFrameReadback {
+public:
+    static constexpr size_t DEFAULT_QUEUE_DEPTH = 4;
+
+    struct Frame {
+        uint64_t number;
+        uint32_t width;
+        uint32_t height;
+        // height rows of width * 4 bytes, top row first
+        std::vector<uint8_t> rgba;
+    };
+    // called on the encoder thread, in frame order
+    using Sink = std::function<void(const Frame &)>;
+
+    // writes the bare pixels one frame after the other (e.g. into a pipe to ffmpeg -f rawvideo)
+    static Sink rawSink(std::FILE *file);
+    // writes <prefix>000000.png, <prefix>000001.png, ...
+    static Sink pngSequenceSink(const std::string &prefix);
+
+    // frames are read from images of the given extent in a 4 byte per pixel rgba format
+    LveFrameReadback(
+        LveDevice &device, VkExtent2D extent, int frameSlots, Sink sink, size_t queueDepth = DEFAULT_QUEUE_DEPTH);
+    // the gpu has to be done with the buffers, call finish() first to keep the frames still in flight
+    ~LveFrameReadback();
+    LveFrameReadback(const LveFrameReadback &) = delete;
+    LveFrameReadback &operator=(const LveFrameReadback &) = delete;
+
+    // Records the copy of image (in TRANSFER_SRC_OPTIMAL) into the slot's buffer, outside of a render pass.
+    // Must be called after the renderer's beginFrame, which waited for the slot's previous frame.
+    // Rethrows on the calling thread if the encoder failed.
+    void readFrame(VkCommandBuffer commandBuffer, int frameSlot, VkImage image);
+    // After every frame has finished on the gpu (vkDeviceWaitIdle): hands the frames still sitting in
+    // the buffers to the encoder and waits until everything is written.
+    void finish();
+
+    uint64_t framesWritten() const;
+    // seconds the render thread waited for the encoder since the last call
+    double takeStallTime();
+
+private:
+    struct Slot {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        LveAllocation memory;
+        bool pending = false;
+        uint64_t frame = 0;
+    };
+
+    // moves the slot's finished frame into the encoder queue
+    void collect(Slot &slot);
+    void encoderLoop();
+    void rethrowEncoderError();
+    void destroySlots();
+
+    LveDevice &lveDevice;
+    VkExtent2D extent;
+    VkDeviceSize frameSize;
+    std::vector<Slot> slots;
+    uint64_t nextFrame = 0;
+    double stallTime = 0.0;
+
+    Sink sink;
+    size_t queueDepth;
+    mutable std::mutex mutex;
+    std::condition_variable frameQueued;
+    std::condition_variable frameDone;
+    std::deque<Frame> queue;
+    // pixel vectors the encoder is done with, reused instead of allocating a frame each time
+    std::vector<std::vector<uint8_t>> freeFrames;
+    uint64_t written = 0;
+    bool stopping = false;
+    // stays set once the sink failed so the frames still queued are dropped, it is rethrown once
+    std::exception_ptr encoderError;
+    bool errorRethrown = false;
+    std::thread encoder;
+};
+
+} // namespace lve
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "lve_mesh_arena.hpp"
 #include "lve_model.hpp"
 
 #include <memory>
@@ -8,7 +9,7 @@ struct Transform2dComponent {
     glm::vec2 translation{}; // position offset
     float rotation;
     glm::vec2 scale{1.f,1.f};
-    glm::mat2 mat2() {
+    glm::mat2 mat2() const {
         float s = glm::sin(rotation);
         float c = glm::cos(rotation);
         glm::mat2 rotMatrix {{c, s}, {-s, c}};
@@ -36,6 +37,9 @@ public:
     id_t const getId (){ return id; }
 
     std::shared_ptr<LveModel> model{};
+    // drawn instead of model when set: the object's range of a buffer shared with other objects
+    std::shared_ptr<LveMeshArena> meshArena{};
+    LveMeshRange mesh{};
     glm::vec3 color{};
     Transform2dComponent transform2d{};
 
@@ -0,0 +1,185 @@
+#include "lve_gpu_profiler.hpp"
+#include "lve_trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+namespace lve {
+
+LveGpuProfiler::LveGpuProfiler(LveDevice &device, int frameSlots) : lveDevice{device} {
+    // timestampComputeAndGraphics guarantees timestamps on every graphics and compute queue
+    // validBits 0 means no timestamps at all on the graphics queue
+    uint32_t validBits = lveDevice.graphicsTimestampValidBits();
+    supported = lveDevice.properties.limits.timestampComputeAndGraphics == VK_TRUE && validBits > 0;
+    timestampPeriodNs = lveDevice.properties.limits.timestampPeriod;
+    // the bits above validBits are undefined
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    if (!supported) {
+        return;
+    }
+
+    slots.resize(frameSlots);
+    for (auto &slot : slots) {
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = 2 * MAX_SCOPES_PER_FRAME;
+        if (vkCreateQueryPool(lveDevice.device(), &poolInfo, nullptr, &slot.queryPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timestamp query pool");
+        }
+    }
+    timestamps.resize(2 * MAX_SCOPES_PER_FRAME);
+    calibrate();
+}
+
+void LveGpuProfiler::calibrate() {
+    // Without VK_EXT_calibrated_timestamps the best guess is the middle of a submit that only writes
+    // a timestamp, the error is at most half of that round trip (tens of microseconds).
+    VkQueryPool queryPool = slots[0].queryPool;
+    VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+    vkCmdResetQueryPool(commandBuffer, queryPool, 0, 1);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, 0);
+    auto before = std::chrono::steady_clock::now();
+    lveDevice.endSingleTimeCommands(commandBuffer);
+    auto after = std::chrono::steady_clock::now();
+
+    vkGetQueryPoolResults(
+        lveDevice.device(),
+        queryPool,
+        0,
+        1,
+        sizeof(uint64_t),
+        &calibrationTimestamp,
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+    calibrationSteadyNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>((before + (after - before) / 2).time_since_epoch()).count();
+}
+
+uint64_t LveGpuProfiler::toSteadyClockNs(uint64_t timestamp) const {
+    // every timestamp is written after the calibration one, a smaller value means the counter wrapped
+    double deltaNs = static_cast<double>(ticks(calibrationTimestamp, timestamp)) * timestampPeriodNs;
+    return static_cast<uint64_t>(calibrationSteadyNs + static_cast<int64_t>(deltaNs));
+}
+
+LveGpuProfiler::~LveGpuProfiler() {
+    for (auto &slot : slots) {
+        vkDestroyQueryPool(lveDevice.device(), slot.queryPool, nullptr);
+    }
+}
+
+void LveGpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameSlot) {
+    if (!supported) {
+        return;
+    }
+    currentSlot = &slots[frameSlot];
+    collect(*currentSlot);
+    currentSlot->scopes.clear();
+    // queries have to be reset before they are written again
+    vkCmdResetQueryPool(commandBuffer, currentSlot->queryPool, 0, 2 * MAX_SCOPES_PER_FRAME);
+}
+
+uint32_t LveGpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char *name, int index) {
+    if (!supported || currentSlot == nullptr || currentSlot->scopes.size() >= MAX_SCOPES_PER_FRAME) {
+        return UINT32_MAX;
+    }
+    uint32_t scope = static_cast<uint32_t>(currentSlot->scopes.size());
+    currentSlot->scopes.push_back({name, index});
+    // top of pipe: the timestamp is written as soon as the previous commands have started
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, currentSlot->queryPool, 2 * scope);
+    return scope;
+}
+
+void LveGpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+    if (scope == UINT32_MAX) {
+        return;
+    }
+    // bottom of pipe: written once every command recorded before it has finished
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, currentSlot->queryPool, 2 * scope + 1);
+}
+
+void LveGpuProfiler::collect(FrameSlot &slot) {
+    if (slot.scopes.empty()) {
+        return;
+    }
+    uint32_t queryCount = static_cast<uint32_t>(2 * slot.scopes.size());
+    // no WAIT flag: the slot's fence has signaled, if the results are still not there the frame is skipped
+    VkResult result = vkGetQueryPoolResults(
+        lveDevice.device(),
+        slot.queryPool,
+        0,
+        queryCount,
+        queryCount * sizeof(uint64_t),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    for (size_t i = 0; i < slot.scopes.size(); i++) {
+        const auto &scope = slot.scopes[i];
+        std::string key = scope.name;
+        if (scope.index >= 0) {
+            key += " " + std::to_string(scope.index);
+        }
+        double ms = static_cast<double>(ticks(timestamps[2 * i], timestamps[2 * i + 1])) * timestampPeriodNs * 1e-6;
+        if (LveTrace::isEnabled()) {
+            LveTrace::addGpuEvent(
+                scope.name,
+                scope.index,
+                LveTrace::toTraceTime(toSteadyClockNs(timestamps[2 * i])),
+                LveTrace::toTraceTime(toSteadyClockNs(timestamps[2 * i + 1])));
+        }
+
+        auto &scopeSamples = samples[key];
+        if (scopeSamples.ms.size() < MAX_SAMPLES) {
+            scopeSamples.ms.push_back(ms);
+        } else {
+            scopeSamples.ms[scopeSamples.next] = ms;
+            scopeSamples.next = (scopeSamples.next + 1) % MAX_SAMPLES;
+        }
+    }
+}
+
+std::vector<LveGpuProfiler::ScopeStats> LveGpuProfiler::stats() const {
+    std::vector<ScopeStats> result;
+    for (const auto &entry : samples) {
+        std::vector<double> sorted = entry.second.ms;
+        if (sorted.empty()) {
+            continue;
+        }
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (double ms : sorted) {
+            sum += ms;
+        }
+        size_t p99 = static_cast<size_t>(std::ceil(0.99 * sorted.size())) - 1;
+        result.push_back({entry.first, sorted.size(), sorted.front(), sum / sorted.size(), sorted[p99]});
+    }
+    return result;
+}
+
+void LveGpuProfiler::reset() {
+    samples.clear();
+}
+
+void LveGpuProfiler::printReport(std::ostream &out) const {
+    if (!supported) {
+        out << "gpu timestamps are not supported on this device" << std::endl;
+        return;
+    }
+    auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+    for (const auto &scope : stats()) {
+        out << "  gpu " << std::left << std::setw(16) << scope.name << std::right
+            << " min " << scope.minMs << " avg " << scope.avgMs << " p99 " << scope.p99Ms
+            << " ms (" << scope.samples << " frames)" << std::endl;
+    }
+    out.flags(flags);
+}
+
+} // namespace lve
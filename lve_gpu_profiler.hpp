@@ -0,0 +1,90 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// GPU timings from timestamp queries.
+// Every frame slot (frame in flight) has its own query pool. beginFrame() is called when a slot is
+// reused, at that point the renderer has already waited for the slot's fence, so the timestamps
+// written by that slot framesInFlight frames ago are available and are read without ever stalling.
+// Scopes are identified by a static name plus an optional index (e.g. "draw", depth) and aggregated
+// into min / avg / p99 gpu milliseconds until reset(). While LveTrace is running they also show up
+// on its gpu track, moved onto the cpu clock with an offset measured once at startup.
+class LveGpuProfiler {
+public:
+    static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+    // samples kept per scope between two resets, older ones are overwritten
+    static constexpr size_t MAX_SAMPLES = 4096;
+
+    struct ScopeStats {
+        std::string name;
+        size_t samples;
+        double minMs;
+        double avgMs;
+        double p99Ms;
+    };
+
+    LveGpuProfiler(LveDevice &device, int frameSlots);
+    ~LveGpuProfiler();
+    LveGpuProfiler(const LveGpuProfiler &) = delete;
+    LveGpuProfiler &operator=(const LveGpuProfiler &) = delete;
+
+    // false when the graphics queue can't write timestamps, every call is a no-op then
+    bool isSupported() const { return supported; }
+
+    // collects the results of the slot's previous frame and resets its queries,
+    // has to be recorded outside of a render pass
+    void beginFrame(VkCommandBuffer commandBuffer, int frameSlot);
+    // returns an id for endScope, name must outlive the profiler (a string literal)
+    uint32_t beginScope(VkCommandBuffer commandBuffer, const char *name, int index = -1);
+    void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+    std::vector<ScopeStats> stats() const;
+    void reset();
+    void printReport(std::ostream &out) const;
+
+private:
+    struct ScopeInfo {
+        const char *name;
+        int index;
+    };
+
+    struct FrameSlot {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        std::vector<ScopeInfo> scopes;
+    };
+
+    struct Samples {
+        std::vector<double> ms;
+        size_t next = 0;
+    };
+
+    void collect(FrameSlot &slot);
+    // pairs one gpu timestamp with the steady_clock time it was written at
+    void calibrate();
+    uint64_t toSteadyClockNs(uint64_t timestamp) const;
+    // ticks from begin to end, right across a wrap of the counter
+    uint64_t ticks(uint64_t begin, uint64_t end) const { return (end - begin) & timestampMask; }
+
+    LveDevice &lveDevice;
+    bool supported;
+    double timestampPeriodNs;
+    // the queue's timestampValidBits set, the counter wraps around at the top one
+    uint64_t timestampMask = ~0ull;
+    std::vector<FrameSlot> slots;
+    FrameSlot *currentSlot = nullptr;
+    std::vector<uint64_t> timestamps;
+    std::map<std::string, Samples> samples;
+    uint64_t calibrationTimestamp = 0;
+    int64_t calibrationSteadyNs = 0;
+};
+
+} // namespace lve
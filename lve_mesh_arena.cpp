@@ -0,0 +1,89 @@
+#include "lve_mesh_arena.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+LveMeshArena::LveMeshArena(LveDevice &device, VertexFormat vertexFormat) : lveDevice{device}, format{vertexFormat} {}
+
+LveMeshArena::~LveMeshArena() {
+    if (buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(lveDevice.device(), buffer, nullptr);
+        lveDevice.allocator().free(bufferMemory);
+    }
+}
+
+LveMeshRange LveMeshArena::add(const std::vector<LveModel::Vertex> &vertices, const std::vector<uint32_t> &indices) {
+    assert(buffer == VK_NULL_HANDLE && "meshes have to be added before upload()");
+    assert(vertices.size() >= 3 && "Vertex count must be at least 3");
+    if (vertices.size() > UINT32_MAX - totalVertices || indices.size() > UINT32_MAX - indexData.size()) {
+        throw std::runtime_error("mesh arena: more than 2^32 vertices or indices");
+    }
+    LveMeshRange range{};
+    range.firstVertex = totalVertices;
+    range.vertexCount = static_cast<uint32_t>(vertices.size());
+    range.firstIndex = static_cast<uint32_t>(indexData.size());
+    range.indexCount = static_cast<uint32_t>(indices.size());
+
+    VkDeviceSize stride = LveModel::vertexSize(format);
+    size_t offset = vertexData.size();
+    vertexData.resize(offset + stride * vertices.size());
+    LveModel::writeVertices(vertices.data(), vertices.size(), format, vertexData.data() + offset);
+    indexData.insert(indexData.end(), indices.begin(), indices.end());
+
+    totalVertices += range.vertexCount;
+    if (!indices.empty()) {
+        largestMesh = std::max(largestMesh, range.vertexCount);
+    }
+    return range;
+}
+
+void LveMeshArena::upload(LveUploader &uploader) {
+    assert(buffer == VK_NULL_HANDLE && "the arena was already uploaded");
+    assert(!vertexData.empty() && "nothing to upload");
+    indexType = largestMesh <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    VkDeviceSize indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    // index buffer offsets have to be a multiple of the index size
+    indexOffset = (vertexData.size() + 3) & ~VkDeviceSize{3};
+    bufferSize = indexOffset + indexSize * indexData.size();
+
+    lveDevice.createBuffer(
+        bufferSize,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        buffer,
+        bufferMemory);
+    uploader.upload(buffer, 0, vertexData.data(), vertexData.size());
+    if (indexType == VK_INDEX_TYPE_UINT16) {
+        std::vector<uint16_t> shortIndices(indexData.begin(), indexData.end());
+        uploader.upload(buffer, indexOffset, shortIndices.data(), indexSize * shortIndices.size());
+    } else if (!indexData.empty()) {
+        uploader.upload(buffer, indexOffset, indexData.data(), indexSize * indexData.size());
+    }
+
+    // the uploader copied everything into its staging buffer
+    std::vector<char>().swap(vertexData);
+    std::vector<uint32_t>().swap(indexData);
+}
+
+void LveMeshArena::bind(VkCommandBuffer commandBuffer) const {
+    assert(buffer != VK_NULL_HANDLE && "the arena has to be uploaded before it is bound");
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+    if (bufferSize > indexOffset) {
+        vkCmdBindIndexBuffer(commandBuffer, buffer, indexOffset, indexType);
+    }
+}
+
+void LveMeshArena::draw(VkCommandBuffer commandBuffer, const LveMeshRange &range, uint32_t instanceCount) const {
+    if (range.indexCount > 0) {
+        vkCmdDrawIndexed(
+            commandBuffer, range.indexCount, instanceCount, range.firstIndex, static_cast<int32_t>(range.firstVertex), 0);
+    } else {
+        vkCmdDraw(commandBuffer, range.vertexCount, instanceCount, range.firstVertex, 0);
+    }
+}
+
+} // namespace lve
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+#include "lve_uploader.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// where one mesh lives inside an LveMeshArena
+struct LveMeshRange {
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
+    // indexCount == 0 draws the vertices without indices
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+};
+
+// All meshes in one device local buffer: vertices first, indices after them. Instead of a buffer
+// (and an allocation rounded up to its alignment) per mesh there is one of each, and a render
+// system binds the arena once and draws every mesh as a sub-range of it.
+// Indices stay relative to their mesh, the draw passes firstVertex as vertexOffset, so they are
+// stored as 16 bit whenever no single mesh has more than 65536 vertices.
+// Meshes are collected on the cpu with add() and go to the gpu in one go with upload().
+// The arena is append-only: ranges are never freed or reused, its buffer has a fixed size from
+// upload() until the arena itself is destroyed. The app builds one for all levels up front and
+// shares it between the game objects, an erased level's range stays until the last one is gone.
+class LveMeshArena {
+public:
+    explicit LveMeshArena(LveDevice &device, VertexFormat vertexFormat = VertexFormat::Float);
+    ~LveMeshArena();
+    LveMeshArena(const LveMeshArena &) = delete;
+    LveMeshArena &operator=(const LveMeshArena &) = delete;
+
+    // copies (and packs) the mesh, indices are relative to its own vertices
+    LveMeshRange add(const std::vector<LveModel::Vertex> &vertices, const std::vector<uint32_t> &indices = {});
+    // creates the buffer and queues the copy on the uploader, the meshes can be drawn after
+    // uploader.flush(); the cpu copies are released
+    void upload(LveUploader &uploader);
+
+    void bind(VkCommandBuffer commandBuffer) const;
+    // the arena has to be bound
+    void draw(VkCommandBuffer commandBuffer, const LveMeshRange &range, uint32_t instanceCount = 1) const;
+
+    VertexFormat vertexFormat() const { return format; }
+    // bytes of gpu memory used by the vertices and indices
+    VkDeviceSize memorySize() const { return bufferSize; }
+
+private:
+    LveDevice &lveDevice;
+    VertexFormat format;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    LveAllocation bufferMemory{};
+    VkDeviceSize bufferSize = 0;
+    VkDeviceSize indexOffset = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+
+    // until upload()
+    std::vector<char> vertexData;
+    std::vector<uint32_t> indexData;
+    uint32_t totalVertices = 0;
+    uint32_t largestMesh = 0;
+};
+
+} // namespace lve
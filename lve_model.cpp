@@ -1,44 +1,137 @@
 #include "lve_model.hpp"
+#include <algorithm>
 #include <cassert>
-#include <cstring>
+#include <cmath>
 
 namespace lve{
 
 
        LveModel::LveModel(LveDevice &device, const std::vector<Vertex> &vertices) : lveDevice{device}{
-            createVertexBuffers(vertices);
+            LveUploader uploader{device, sizeof(Vertex) * vertices.size()};
+            createVertexBuffers(vertices, uploader);
+            uploader.flush();
+        }
+        LveModel::LveModel(LveDevice &device, LveUploader &uploader, const std::vector<Vertex> &vertices) : lveDevice{device}{
+            createVertexBuffers(vertices, uploader);
+        }
+        LveModel::LveModel(LveDevice &device, LveUploader &uploader, const std::vector<Vertex> &vertices, VertexFormat format) : lveDevice{device}{
+            createVertexBuffers(vertices, uploader, format);
+        }
+        LveModel::LveModel(
+            LveDevice &device,
+            LveUploader &uploader,
+            const std::vector<Vertex> &vertices,
+            const std::vector<uint32_t> &indices,
+            VertexFormat format) : lveDevice{device}{
+            createVertexBuffers(vertices, uploader, format);
+            createIndexBuffers(indices, uploader);
+        }
+        LveModel::LveModel(LveDevice &device, LveUploader &uploader, const std::vector<Vertex> &vertices, const std::vector<Instance> &instances) : lveDevice{device}{
+            createVertexBuffers(vertices, uploader);
+            createInstanceBuffers(instances, uploader);
+        }
+        LveModel::LveModel(LveDevice &device, VkBuffer vertexBuffer, LveAllocation vertexBufferMemory, uint32_t vertexCount)
+            : lveDevice{device}, vertexBuffer{vertexBuffer}, vertexBufferMemory{vertexBufferMemory}, vertexCount{vertexCount}{
+            assert(vertexCount >=3 && "Vertex count must be at least 3");
         }
         LveModel::~LveModel(){
             vkDestroyBuffer(lveDevice.device(), vertexBuffer, nullptr);
-            vkFreeMemory(lveDevice.device(), vertexBufferMemory, nullptr);
+            lveDevice.allocator().free(vertexBufferMemory);
+            if (indexBuffer != VK_NULL_HANDLE) {
+                vkDestroyBuffer(lveDevice.device(), indexBuffer, nullptr);
+                lveDevice.allocator().free(indexBufferMemory);
+            }
+            if (instanceBuffer != VK_NULL_HANDLE) {
+                vkDestroyBuffer(lveDevice.device(), instanceBuffer, nullptr);
+                lveDevice.allocator().free(instanceBufferMemory);
+            }
         }
-        void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices){
+        void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices, LveUploader &uploader){
             vertexCount = static_cast<uint32_t>(vertices.size());
             assert(vertexCount >=3 && "Vertex count must be at least 3");
             VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-            lveDevice.createBuffer(
-                bufferSize,
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                //host is cpu, device is gpu
-                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                vertexBuffer,
-                vertexBufferMemory);
+            createDeviceLocalBuffer(vertices.data(), bufferSize, uploader, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
+        }
 
-            void *data;
-            //first 0 is offset,
-            //second 0 is for not providing map flag(?)
-            vkMapMemory(lveDevice.device(), vertexBufferMemory, 0, bufferSize, 0, &data);
-            memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-            vkUnmapMemory(lveDevice.device(), vertexBufferMemory);
+        void LveModel::createVertexBuffers(const std::vector<Vertex> &vertices, LveUploader &uploader, VertexFormat format){
+            if (format == VertexFormat::Float) {
+                createVertexBuffers(vertices, uploader);
+                return;
+            }
+            vertexCount = static_cast<uint32_t>(vertices.size());
+            assert(vertexCount >=3 && "Vertex count must be at least 3");
+            vertexStride = vertexSize(format);
+            std::vector<char> packed(vertexStride * vertexCount);
+            writeVertices(vertices.data(), vertexCount, format, packed.data());
+            createDeviceLocalBuffer(packed.data(), packed.size(), uploader, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertexBuffer, vertexBufferMemory);
+        }
+
+        void LveModel::createIndexBuffers(const std::vector<uint32_t> &indices, LveUploader &uploader){
+            indexCount = static_cast<uint32_t>(indices.size());
+            assert(indexCount >= 3 && "Index count must be at least 3");
+            // half the index memory and bandwidth whenever every index fits
+            if (vertexCount <= 65536) {
+                std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+                indexType = VK_INDEX_TYPE_UINT16;
+                createDeviceLocalBuffer(shortIndices.data(), sizeof(uint16_t) * indexCount, uploader, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+            } else {
+                indexType = VK_INDEX_TYPE_UINT32;
+                createDeviceLocalBuffer(indices.data(), sizeof(uint32_t) * indexCount, uploader, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexBuffer, indexBufferMemory);
+            }
+        }
+
+        void LveModel::createInstanceBuffers(const std::vector<Instance> &instances, LveUploader &uploader){
+            instanceCount = static_cast<uint32_t>(instances.size());
+            assert(instanceCount >= 1 && "Instance count must be at least 1");
+            VkDeviceSize bufferSize = sizeof(instances[0]) * instanceCount;
+            createDeviceLocalBuffer(instances.data(), bufferSize, uploader, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, instanceBuffer, instanceBufferMemory);
+        }
+
+        void LveModel::createDeviceLocalBuffer(
+            const void *data,
+            VkDeviceSize size,
+            LveUploader &uploader,
+            VkBufferUsageFlags usage,
+            VkBuffer &buffer,
+            LveAllocation &bufferMemory){
+            // host is cpu, device is gpu
+            // device local memory is the fast memory of the gpu, on discrete gpus the cpu can't map it,
+            // so the data goes through the uploader's host visible staging buffer and a copy on the gpu
+            lveDevice.createBuffer(
+                size,
+                usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                buffer,
+                bufferMemory);
+            uploader.upload(buffer, 0, data, size);
         }
 
         void LveModel::draw(VkCommandBuffer commandBuffer){
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+            if (indexBuffer != VK_NULL_HANDLE) {
+                vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, 0);
+            } else {
+                vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, 0);
+            }
         }
         void LveModel::bind(VkCommandBuffer commandBuffer){
-            VkBuffer buffers[] = {vertexBuffer};
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+            VkBuffer buffers[] = {vertexBuffer, instanceBuffer};
+            VkDeviceSize offsets[] = {0, 0};
+            uint32_t bindingCount = instanceBuffer != VK_NULL_HANDLE ? 2 : 1;
+            vkCmdBindVertexBuffers(commandBuffer, 0, bindingCount, buffers, offsets);
+            if (indexBuffer != VK_NULL_HANDLE) {
+                vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+            }
+        }
+
+        VkDeviceSize LveModel::memorySize() const{
+            VkDeviceSize size = vertexStride * vertexCount;
+            if (indexBuffer != VK_NULL_HANDLE) {
+                size += (indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)) * indexCount;
+            }
+            if (instanceBuffer != VK_NULL_HANDLE) {
+                size += sizeof(Instance) * instanceCount;
+            }
+            return size;
         }
 
         std::vector<VkVertexInputBindingDescription> LveModel::Vertex::getBindingDescription(){
@@ -68,4 +161,138 @@ namespace lve{
 
             return attributeDescription;
         }
+
+        std::vector<VkVertexInputBindingDescription> LveModel::PackedVertex16::getBindingDescription(){
+            std::vector<VkVertexInputBindingDescription> bindingDescription(1);
+            bindingDescription[0].binding = 0;
+            bindingDescription[0].stride = sizeof(PackedVertex16);
+            bindingDescription[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            return bindingDescription;
+        }
+        std::vector<VkVertexInputAttributeDescription> LveModel::PackedVertex16::getAttributeDescription(){
+            // SINT, not SNORM: the shader scales by a power of two, which keeps the positions exact
+            std::vector<VkVertexInputAttributeDescription> attributeDescription(1);
+            attributeDescription[0].binding = 0;
+            attributeDescription[0].location = 0;
+            attributeDescription[0].format = VK_FORMAT_R16G16_SINT;
+            attributeDescription[0].offset = offsetof(PackedVertex16, x);
+            return attributeDescription;
+        }
+
+        std::vector<VkVertexInputBindingDescription> LveModel::PackedVertex32::getBindingDescription(){
+            std::vector<VkVertexInputBindingDescription> bindingDescription(1);
+            bindingDescription[0].binding = 0;
+            bindingDescription[0].stride = sizeof(PackedVertex32);
+            bindingDescription[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            return bindingDescription;
+        }
+        std::vector<VkVertexInputAttributeDescription> LveModel::PackedVertex32::getAttributeDescription(){
+            std::vector<VkVertexInputAttributeDescription> attributeDescription(1);
+            attributeDescription[0].binding = 0;
+            attributeDescription[0].location = 0;
+            attributeDescription[0].format = VK_FORMAT_R32G32_SINT;
+            attributeDescription[0].offset = offsetof(PackedVertex32, x);
+            return attributeDescription;
+        }
+
+        std::vector<VkVertexInputBindingDescription> LveModel::getBindingDescription(VertexFormat format){
+            switch (format) {
+            case VertexFormat::Packed16:
+                return PackedVertex16::getBindingDescription();
+            case VertexFormat::Packed32:
+                return PackedVertex32::getBindingDescription();
+            default:
+                return Vertex::getBindingDescription();
+            }
+        }
+        std::vector<VkVertexInputAttributeDescription> LveModel::getAttributeDescription(VertexFormat format){
+            switch (format) {
+            case VertexFormat::Packed16:
+                return PackedVertex16::getAttributeDescription();
+            case VertexFormat::Packed32:
+                return PackedVertex32::getAttributeDescription();
+            default:
+                return Vertex::getAttributeDescription();
+            }
+        }
+
+        float LveModel::positionScale(VertexFormat format){
+            switch (format) {
+            case VertexFormat::Packed16:
+                return std::ldexp(1.0f, -PackedVertex16::FRACTION_BITS);
+            case VertexFormat::Packed32:
+                return std::ldexp(1.0f, -PackedVertex32::FRACTION_BITS);
+            default:
+                return 1.0f;
+            }
+        }
+
+        int LveModel::maxExactLevel(VertexFormat format){
+            // level k has x on multiples of 2^-k, |x| <= 1 needs k + 1 significant bits
+            if (format == VertexFormat::Packed16) {
+                return PackedVertex16::FRACTION_BITS;
+            }
+            // a float mantissa holds 24 bits, PackedVertex32 has more than that
+            return 23;
+        }
+
+        VkDeviceSize LveModel::vertexSize(VertexFormat format){
+            switch (format) {
+            case VertexFormat::Packed16:
+                return sizeof(PackedVertex16);
+            case VertexFormat::Packed32:
+                return sizeof(PackedVertex32);
+            default:
+                return sizeof(Vertex);
+            }
+        }
+
+        namespace {
+            template <typename Packed>
+            void packVertices(const LveModel::Vertex *vertices, size_t count, Packed *out){
+                for (size_t i = 0; i < count; i++) {
+                    float x = std::ldexp(vertices[i].position.x, Packed::FRACTION_BITS);
+                    float y = std::ldexp(vertices[i].position.y, Packed::FRACTION_BITS);
+                    // a level deeper than the format supports would silently snap to the grid
+                    assert(x == std::round(x) && y == std::round(y) && "position is not exact in the packed vertex format");
+                    out[i].x = static_cast<decltype(out[i].x)>(x);
+                    out[i].y = static_cast<decltype(out[i].y)>(y);
+                }
+            }
+        }
+
+        void LveModel::writeVertices(const Vertex *vertices, size_t count, VertexFormat format, void *out){
+            switch (format) {
+            case VertexFormat::Float:
+                std::copy(vertices, vertices + count, static_cast<Vertex *>(out));
+                break;
+            case VertexFormat::Packed16:
+                packVertices(vertices, count, static_cast<PackedVertex16 *>(out));
+                break;
+            case VertexFormat::Packed32:
+                packVertices(vertices, count, static_cast<PackedVertex32 *>(out));
+                break;
+            }
+        }
+
+        std::vector<VkVertexInputBindingDescription> LveModel::Instance::getBindingDescription(){
+            auto bindingDescription = Vertex::getBindingDescription();
+            VkVertexInputBindingDescription instanceBinding{};
+            instanceBinding.binding = 1;
+            instanceBinding.stride = sizeof(Instance);
+            // advance once per instance instead of once per vertex
+            instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+            bindingDescription.push_back(instanceBinding);
+            return bindingDescription;
+        }
+        std::vector<VkVertexInputAttributeDescription> LveModel::Instance::getAttributeDescription(){
+            auto attributeDescription = Vertex::getAttributeDescription();
+            VkVertexInputAttributeDescription offsetAttribute{};
+            offsetAttribute.binding = 1;
+            offsetAttribute.location = 2;
+            offsetAttribute.format = VK_FORMAT_R32G32_SFLOAT;
+            offsetAttribute.offset = offsetof(Instance, offset);
+            attributeDescription.push_back(offsetAttribute);
+            return attributeDescription;
+        }
 }
\ No newline at end of file
@@ -1,16 +1,28 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_uploader.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
 
+#include <cstdint>
 #include <vector>
 
 namespace lve
 {
+    // layout of the vertex buffer of an LveModel
+    enum class VertexFormat {
+        // LveModel::Vertex, 20 bytes
+        Float,
+        // LveModel::PackedVertex16, 4 bytes
+        Packed16,
+        // LveModel::PackedVertex32, 8 bytes
+        Packed32,
+    };
+
     class LveModel
     {
     public:
@@ -22,20 +34,97 @@ namespace lve
         static std::vector<VkVertexInputBindingDescription> getBindingDescription();
         static std::vector<VkVertexInputAttributeDescription> getAttributeDescription();
     };
+
+    // Positions only, in fixed point: every Sierpinski corner sits on a grid of 2^-level, so with
+    // enough fraction bits the positions stay exact while the color the shaders never read is gone.
+    // packed_shader.vert reads them as ivec2 and multiplies by 2^-FRACTION_BITS.
+    // 16 bit: exact for levels up to 14 (y steps by 2 * 2^-level, positions stay within +-1)
+    struct PackedVertex16
+    {
+        static constexpr int FRACTION_BITS = 14;
+        int16_t x, y;
+        static std::vector<VkVertexInputBindingDescription> getBindingDescription();
+        static std::vector<VkVertexInputAttributeDescription> getAttributeDescription();
+    };
+    // 32 bit: exact as long as a float is, the shader converts to float anyway
+    struct PackedVertex32
+    {
+        static constexpr int FRACTION_BITS = 30;
+        int32_t x, y;
+        static std::vector<VkVertexInputBindingDescription> getBindingDescription();
+        static std::vector<VkVertexInputAttributeDescription> getAttributeDescription();
+    };
+    static std::vector<VkVertexInputBindingDescription> getBindingDescription(VertexFormat format);
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescription(VertexFormat format);
+    // 2^-FRACTION_BITS of the packed formats, 1 for Float
+    static float positionScale(VertexFormat format);
+    // deepest level whose positions the format stores exactly
+    static int maxExactLevel(VertexFormat format);
+    // bytes per vertex
+    static VkDeviceSize vertexSize(VertexFormat format);
+    // converts count vertices to format, out needs count * vertexSize(format) bytes
+    static void writeVertices(const Vertex *vertices, size_t count, VertexFormat format, void *out);
+
+    // per instance data, read once per drawn copy of the vertices
+    struct Instance
+    {
+        glm::vec2 offset;
+        // Vertex bindings and attributes plus the instance buffer at binding 1, location 2
+        static std::vector<VkVertexInputBindingDescription> getBindingDescription();
+        static std::vector<VkVertexInputAttributeDescription> getAttributeDescription();
+    };
     
+        // uploads right away through its own staging buffer
         LveModel(LveDevice &device, const std::vector<Vertex> &vertices);
+        // queues the upload on a shared uploader, the model can be drawn after uploader.flush()
+        LveModel(LveDevice &device, LveUploader &uploader, const std::vector<Vertex> &vertices);
+        // converts the positions to a packed format on the way, the vertices have to be exact in it
+        LveModel(LveDevice &device, LveUploader &uploader, const std::vector<Vertex> &vertices, VertexFormat format);
+        // indexed, drawn with vkCmdDrawIndexed; the indices are stored as 16 bit when the vertex count allows it
+        LveModel(
+            LveDevice &device,
+            LveUploader &uploader,
+            const std::vector<Vertex> &vertices,
+            const std::vector<uint32_t> &indices,
+            VertexFormat format = VertexFormat::Float);
+        // draws the vertices once per instance
+        LveModel(LveDevice &device, LveUploader &uploader, const std::vector<Vertex> &vertices, const std::vector<Instance> &instances);
+        // takes ownership of a vertex buffer that was filled on the gpu
+        LveModel(LveDevice &device, VkBuffer vertexBuffer, LveAllocation vertexBufferMemory, uint32_t vertexCount);
         ~LveModel();
         LveModel(const LveModel &) = delete;
         LveModel &operator=(const LveModel &) = delete;
 
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
+        // bytes of gpu memory used by the vertex and instance data
+        VkDeviceSize memorySize() const;
     private:
 
-        void createVertexBuffers(const std::vector<Vertex> &vertices);
+        void createVertexBuffers(const std::vector<Vertex> &vertices, LveUploader &uploader, VertexFormat format);
+        void createVertexBuffers(const std::vector<Vertex> &vertices, LveUploader &uploader);
+        void createIndexBuffers(const std::vector<uint32_t> &indices, LveUploader &uploader);
+        void createInstanceBuffers(const std::vector<Instance> &instances, LveUploader &uploader);
+        void createDeviceLocalBuffer(
+            const void *data,
+            VkDeviceSize size,
+            LveUploader &uploader,
+            VkBufferUsageFlags usage,
+            VkBuffer &buffer,
+            LveAllocation &bufferMemory);
         LveDevice &lveDevice;
         VkBuffer vertexBuffer;
-        VkDeviceMemory vertexBufferMemory;
+        LveAllocation vertexBufferMemory;
         uint32_t vertexCount;
+        VkDeviceSize vertexStride = sizeof(Vertex);
+
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        LveAllocation indexBufferMemory;
+        uint32_t indexCount = 0;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+        VkBuffer instanceBuffer = VK_NULL_HANDLE;
+        LveAllocation instanceBufferMemory;
+        uint32_t instanceCount = 1;
     };
 }
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "lve_offscreen_target.hpp"
+#include "lve_trace.hpp"
+
+// std
+#include <array>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+LveOffscreenTarget::LveOffscreenTarget(LveDevice &device, VkExtent2D extent, int framesInFlight)
+    : device{device}, extent{extent}, framesInFlight{framesInFlight} {
+    if (framesInFlight < 1 || framesInFlight > LveSwapChain::MAX_FRAMES_IN_FLIGHT) {
+        throw std::runtime_error(
+            "frames in flight must be between 1 and " + std::to_string(LveSwapChain::MAX_FRAMES_IN_FLIGHT));
+    }
+    depthFormat = findDepthFormat();
+    createImages();
+    createRenderPass();
+    createFramebuffers();
+    createSyncObjects();
+}
+
+LveOffscreenTarget::~LveOffscreenTarget() {
+    for (auto framebuffer : framebuffers) {
+        vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
+    }
+    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+    for (size_t i = 0; i < colorImages.size(); i++) {
+        vkDestroyImageView(device.device(), colorImageViews[i], nullptr);
+        vkDestroyImage(device.device(), colorImages[i], nullptr);
+        device.allocator().free(colorImageMemorys[i]);
+        vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
+        vkDestroyImage(device.device(), depthImages[i], nullptr);
+        device.allocator().free(depthImageMemorys[i]);
+    }
+    for (auto fence : inFlightFences) {
+        vkDestroyFence(device.device(), fence, nullptr);
+    }
+}
+
+VkResult LveOffscreenTarget::acquireNextImage(uint32_t *imageIndex) {
+    // nothing to acquire, the slot's image is free once the slot's last frame has finished
+    auto waitStart = std::chrono::steady_clock::now();
+    {
+        LveTraceZone zone{"wait frame fence"};
+        vkWaitForFences(
+            device.device(),
+            1,
+            &inFlightFences[currentFrame],
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max());
+    }
+    lastWaitTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+    *imageIndex = static_cast<uint32_t>(currentFrame);
+    return VK_SUCCESS;
+}
+
+VkResult LveOffscreenTarget::submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+    lastWaitTime = 0.0;
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = buffers;
+
+    vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+    {
+        LveTraceZone zone{"submit"};
+        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+    }
+
+    currentFrame = (currentFrame + 1) % framesInFlight;
+    return VK_SUCCESS;
+}
+
+void LveOffscreenTarget::waitForFrames() {
+    vkWaitForFences(
+        device.device(),
+        static_cast<uint32_t>(inFlightFences.size()),
+        inFlightFences.data(),
+        VK_TRUE,
+        std::numeric_limits<uint64_t>::max());
+}
+
+void LveOffscreenTarget::createImages() {
+    colorImages.resize(framesInFlight);
+    colorImageMemorys.resize(framesInFlight);
+    colorImageViews.resize(framesInFlight);
+    depthImages.resize(framesInFlight);
+    depthImageMemorys.resize(framesInFlight);
+    depthImageViews.resize(framesInFlight);
+
+    for (int i = 0; i < framesInFlight; i++) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = extent.width;
+        imageInfo.extent.height = extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        // transfer src so finished frames can be copied out
+        imageInfo.format = COLOR_FORMAT;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colorImages[i], colorImageMemorys[i]);
+
+        imageInfo.format = depthFormat;
+        imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, depthImages[i], depthImageMemorys[i]);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        viewInfo.image = colorImages[i];
+        viewInfo.format = COLOR_FORMAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        if (vkCreateImageView(device.device(), &viewInfo, nullptr, &colorImageViews[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen color image view!");
+        }
+
+        viewInfo.image = depthImages[i];
+        viewInfo.format = depthFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen depth image view!");
+        }
+    }
+}
+
+void LveOffscreenTarget::createRenderPass() {
+    // same attachments as the swap chain's render pass, only the final color layout differs
+    VkAttachmentDescription depthAttachment{};
+    depthAttachment.format = depthFormat;
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthAttachmentRef{};
+    depthAttachmentRef.attachment = 1;
+    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentDescription colorAttachment = {};
+    colorAttachment.format = COLOR_FORMAT;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference colorAttachmentRef = {};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+    subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+    std::array<VkSubpassDependency, 2> dependencies{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].srcStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = 0;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].dstStageMask =
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstAccessMask =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    // copies recorded after the render pass see the finished color image
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+
+    if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create offscreen render pass!");
+    }
+}
+
+void LveOffscreenTarget::createFramebuffers() {
+    framebuffers.resize(framesInFlight);
+    for (int i = 0; i < framesInFlight; i++) {
+        std::array<VkImageView, 2> attachments = {colorImageViews[i], depthImageViews[i]};
+
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+        framebufferInfo.pAttachments = attachments.data();
+        framebufferInfo.width = extent.width;
+        framebufferInfo.height = extent.height;
+        framebufferInfo.layers = 1;
+
+        if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffers[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen framebuffer!");
+        }
+    }
+}
+
+void LveOffscreenTarget::createSyncObjects() {
+    inFlightFences.resize(framesInFlight);
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    for (auto &fence : inFlightFences) {
+        if (vkCreateFence(device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create synchronization objects for a frame!");
+        }
+    }
+}
+
+VkFormat LveOffscreenTarget::findDepthFormat() {
+    return device.findSupportedFormat(
+        {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+}
+
+} // namespace lve
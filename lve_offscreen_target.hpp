@@ -0,0 +1,64 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_render_target.hpp"
+#include "lve_swap_chain.hpp"
+
+#include <vector>
+
+namespace lve {
+
+// Renders into plain color + depth images instead of a swap chain, so frames can be produced
+// without a window, a surface or VK_KHR_swapchain (render farm nodes, CI, lavapipe).
+// Every frame slot owns one color image: acquireNextImage() waits for the slot's fence and then
+// renders into image index == slot. The render pass leaves the color image in
+// TRANSFER_SRC_OPTIMAL, ready to be copied out after the render pass.
+class LveOffscreenTarget : public LveRenderTarget {
+public:
+    // same byte order as the image on screen, sRGB encoded like the swap chain's B8G8R8A8_SRGB
+    static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+    LveOffscreenTarget(
+        LveDevice &device, VkExtent2D extent, int framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+    ~LveOffscreenTarget() override;
+    LveOffscreenTarget(const LveOffscreenTarget &) = delete;
+    LveOffscreenTarget &operator=(const LveOffscreenTarget &) = delete;
+
+    VkRenderPass getRenderPass() override { return renderPass; }
+    VkFramebuffer getFrameBuffer(int index) override { return framebuffers[index]; }
+    VkExtent2D getExtent() override { return extent; }
+    int getFramesInFlight() const override { return framesInFlight; }
+    VkImage getColorImage(int index) { return colorImages[index]; }
+
+    VkResult acquireNextImage(uint32_t *imageIndex) override;
+    VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) override;
+    void waitForFrames() override;
+    double getLastWaitTime() const override { return lastWaitTime; }
+
+private:
+    void createImages();
+    void createRenderPass();
+    void createFramebuffers();
+    void createSyncObjects();
+    VkFormat findDepthFormat();
+
+    LveDevice &device;
+    VkExtent2D extent;
+    int framesInFlight;
+
+    std::vector<VkImage> colorImages;
+    std::vector<LveAllocation> colorImageMemorys;
+    std::vector<VkImageView> colorImageViews;
+    std::vector<VkImage> depthImages;
+    std::vector<LveAllocation> depthImageMemorys;
+    std::vector<VkImageView> depthImageViews;
+    VkFormat depthFormat;
+    VkRenderPass renderPass;
+    std::vector<VkFramebuffer> framebuffers;
+
+    std::vector<VkFence> inFlightFences;
+    size_t currentFrame = 0;
+    double lastWaitTime = 0.0;
+};
+
+} // namespace lve
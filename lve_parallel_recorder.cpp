@@ -0,0 +1,113 @@
+#include "lve_parallel_recorder.hpp"
+#include "lve_trace.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lve {
+
+LveParallelRecorder::LveParallelRecorder(LveDevice &device, LveThreadPool &pool, int frameSlots, unsigned chunkCount)
+    : lveDevice{device}, pool{pool}, chunks{chunkCount > 0 ? chunkCount : pool.threadCount()} {
+    slotChunks.resize(static_cast<size_t>(frameSlots) * chunks);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = lveDevice.findPhysicalQueueFamilies().graphicsFamily;
+    // the whole pool is reset every frame instead of the individual buffers
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    for (auto &chunk : slotChunks) {
+        if (vkCreateCommandPool(lveDevice.device(), &poolInfo, nullptr, &chunk.commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create secondary command pool!");
+        }
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = chunk.commandPool;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &chunk.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate secondary command buffer!");
+        }
+    }
+    recorded.reserve(chunks);
+}
+
+LveParallelRecorder::~LveParallelRecorder() {
+    // destroying a pool frees its buffers
+    for (auto &chunk : slotChunks) {
+        if (chunk.commandPool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(lveDevice.device(), chunk.commandPool, nullptr);
+        }
+    }
+}
+
+void LveParallelRecorder::record(
+    LveRenderer &renderer, VkCommandBuffer primaryCommandBuffer, size_t itemCount, const RecordRange &recordRange) {
+    if (itemCount == 0) {
+        return;
+    }
+    int frameSlot = renderer.getFrameIndex();
+    assert(static_cast<size_t>(frameSlot + 1) * chunks <= slotChunks.size() && "more frame slots than the recorder was created with");
+    Chunk *slot = &slotChunks[static_cast<size_t>(frameSlot) * chunks];
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderer.getSwapChainRenderPass();
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = renderer.getCurrentFramebuffer();
+    VkExtent2D extent = renderer.getExtent();
+
+    // a chunk per thread is enough to keep them busy, more only adds secondaries for the gpu to chew on
+    size_t usedChunks = std::min<size_t>(chunks, itemCount);
+    size_t chunkSize = (itemCount + usedChunks - 1) / usedChunks;
+    usedChunks = (itemCount + chunkSize - 1) / chunkSize;
+
+    for (size_t i = 0; i < usedChunks; i++) {
+        size_t begin = i * chunkSize;
+        size_t end = std::min(begin + chunkSize, itemCount);
+        Chunk &chunk = slot[i];
+        pool.submit(group, [this, &chunk, &inheritanceInfo, &recordRange, extent, begin, end] {
+            LveTraceZone zone{"record chunk"};
+            // the slot's fence was waited in beginFrame, nothing of the previous use is pending
+            vkResetCommandPool(lveDevice.device(), chunk.commandPool, 0);
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                              VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            beginInfo.pInheritanceInfo = &inheritanceInfo;
+            if (vkBeginCommandBuffer(chunk.commandBuffer, &beginInfo) != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin recording secondary command buffer!");
+            }
+
+            // dynamic state isn't inherited from the primary
+            VkViewport viewport{};
+            viewport.x = 0.0f;
+            viewport.y = 0.0f;
+            viewport.width = static_cast<float>(extent.width);
+            viewport.height = static_cast<float>(extent.height);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+            VkRect2D scissor{{0, 0}, extent};
+            vkCmdSetViewport(chunk.commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(chunk.commandBuffer, 0, 1, &scissor);
+
+            recordRange(chunk.commandBuffer, begin, end);
+
+            if (vkEndCommandBuffer(chunk.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record secondary command buffer!");
+            }
+        });
+    }
+    // the calling thread records chunks too
+    pool.wait(group);
+
+    recorded.clear();
+    for (size_t i = 0; i < usedChunks; i++) {
+        recorded.push_back(slot[i].commandBuffer);
+    }
+    vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(recorded.size()), recorded.data());
+}
+
+} // namespace lve
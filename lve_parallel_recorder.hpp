@@ -0,0 +1,60 @@
+#pragma once
+
+#include "lve_device.hpp"
+#include "lve_renderer.hpp"
+#include "lve_thread_pool.hpp"
+
+// std lib headers
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace lve {
+
+// Records the draws of one render pass on the thread pool.
+// The items are split into chunkCount contiguous ranges, every range is recorded into its own
+// secondary command buffer and the primary executes them in range order, so the result is the same
+// as recording everything inline (blending still sees the objects in their original order).
+// Command pools aren't thread safe, so every chunk gets a pool of its own, one set per frame slot:
+// a slot's pools are only reset after LveRenderer::beginFrame waited for the fence of that slot.
+// Give it a pool of its own: record() helps with whatever the pool has queued while it waits, so a
+// pool that also compiles pipelines would stall the frame on a shader compile.
+class LveParallelRecorder {
+public:
+    // records items [begin, end) into commandBuffer, viewport and scissor are already set
+    using RecordRange = std::function<void(VkCommandBuffer commandBuffer, size_t begin, size_t end)>;
+
+    // chunkCount = 0 uses one chunk per pool thread
+    LveParallelRecorder(LveDevice &device, LveThreadPool &pool, int frameSlots, unsigned chunkCount = 0);
+    ~LveParallelRecorder();
+    LveParallelRecorder(const LveParallelRecorder &) = delete;
+    LveParallelRecorder &operator=(const LveParallelRecorder &) = delete;
+
+    // primaryCommandBuffer has to be inside renderer's swap chain render pass, begun with
+    // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. recordRange is called concurrently for
+    // disjoint ranges, this returns once all of them are recorded and executed
+    void record(
+        LveRenderer &renderer,
+        VkCommandBuffer primaryCommandBuffer,
+        size_t itemCount,
+        const RecordRange &recordRange);
+
+    unsigned chunkCount() const { return chunks; }
+
+private:
+    struct Chunk {
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    };
+
+    LveDevice &lveDevice;
+    LveThreadPool &pool;
+    LveThreadPool::TaskGroup group;
+    unsigned chunks;
+    // frameSlots * chunks, slot major
+    std::vector<Chunk> slotChunks;
+    // secondaries recorded this frame, in chunk order
+    std::vector<VkCommandBuffer> recorded;
+};
+
+} // namespace lve
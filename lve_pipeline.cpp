@@ -2,14 +2,39 @@
 #include "lve_model.hpp"
 
 #include <cassert>
-#include <fstream>
-#include <iostream>
+#include <cstring>
 #include <stdexcept>
 
 namespace lve {
 
-LvePipeline::LvePipeline(LveDevice &device, const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo) : lveDevice{device} {
-    createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+void SpecializationConstants::set(uint32_t constantId, uint32_t value) {
+    for (auto &entry : entries) {
+        if (entry.constantID == constantId) {
+            data[entry.offset / sizeof(uint32_t)] = value;
+            return;
+        }
+    }
+    entries.push_back({constantId, static_cast<uint32_t>(data.size() * sizeof(uint32_t)), sizeof(uint32_t)});
+    data.push_back(value);
+}
+
+void SpecializationConstants::set(uint32_t constantId, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    set(constantId, bits);
+}
+
+VkSpecializationInfo SpecializationConstants::info() const {
+    VkSpecializationInfo info{};
+    info.mapEntryCount = static_cast<uint32_t>(entries.size());
+    info.pMapEntries = entries.data();
+    info.dataSize = data.size() * sizeof(uint32_t);
+    info.pData = data.data();
+    return info;
+}
+
+LvePipeline::LvePipeline(LveDevice &device, SpirvSpan vertCode, SpirvSpan fragCode, const PipelineConfigInfo &configInfo) : lveDevice{device} {
+    createGraphicsPipeline(vertCode, fragCode, configInfo);
 }
 
 LvePipeline::~LvePipeline() {
@@ -18,42 +43,12 @@ LvePipeline::~LvePipeline() {
     vkDestroyPipeline(lveDevice.device(), graphicsPipeline, nullptr);
 }
 
-std::vector<char> LvePipeline::readFile(const std::string &filepath) {
-    std::ifstream file{filepath, std::ios::ate | std::ios::binary};
-
-    if (!file.is_open()) {
-        throw std::runtime_error("failed to open file: " + filepath);
-    }
-    // Read from the end of the file to get its size
-    // The reason of using static_cast is making the typecasting safer and readable.
-    // The reason of using size_t instead of unsigned int is that size_t is platform independent.
-    // size of int may vary from platform to platform.
-    // but size_t is always unsigned and is guaranteed to be big enough to contain the size of the biggest object the host system can handle which is 64-bit for a 64-bit system.
-    // reason of using tellg() is that it returns the position of the current character in the input stream.
-    // since we are already at the end of the file, we can use this to get the size of the file.
-    // by using std::ios::ate, we are setting the position of the input stream to the end of the file.
-    size_t fileSize = static_cast<size_t>(file.tellg());
-
-    std::vector<char> buffer(fileSize);
-
-    // seekg() is used to set the position of the input stream to the beginning of the file.
-    file.seekg(0);
-
-    // Vector.data() returns a pointer to the first element of the vector.
-    file.read(buffer.data(), fileSize);
-
-    file.close();
-    return buffer;
-}
-void LvePipeline::createGraphicsPipeline(const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo) {
+void LvePipeline::createGraphicsPipeline(SpirvSpan vertCode, SpirvSpan fragCode, const PipelineConfigInfo &configInfo) {
 
     assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no pipelineLayout provided in configInfo");
     assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline:: no renderPass provided in configInfo");
-    auto vertCode = readFile(vertFilepath);
-    auto fragCode = readFile(fragFilepath);
-
-    createShaderModule(vertCode, &vertShaderModule);
-    createShaderModule(fragCode, &fragShaderModule);
+    createShaderModule(lveDevice, vertCode, &vertShaderModule);
+    createShaderModule(lveDevice, fragCode, &fragShaderModule);
     VkPipelineShaderStageCreateInfo shaderStages[2];
 
     shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -62,7 +57,8 @@ void LvePipeline::createGraphicsPipeline(const std::string &vertFilepath, const
     shaderStages[0].module = vertShaderModule;
     shaderStages[0].flags = 0;
     shaderStages[0].pNext = nullptr;
-    shaderStages[0].pSpecializationInfo = nullptr;
+    VkSpecializationInfo vertSpecializationInfo = configInfo.vertSpecialization.info();
+    shaderStages[0].pSpecializationInfo = configInfo.vertSpecialization.empty() ? nullptr : &vertSpecializationInfo;
 
     shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -70,10 +66,11 @@ void LvePipeline::createGraphicsPipeline(const std::string &vertFilepath, const
     shaderStages[1].module = fragShaderModule;
     shaderStages[1].flags = 0;
     shaderStages[1].pNext = nullptr;
-    shaderStages[1].pSpecializationInfo = nullptr;
+    VkSpecializationInfo fragSpecializationInfo = configInfo.fragSpecialization.info();
+    shaderStages[1].pSpecializationInfo = configInfo.fragSpecialization.empty() ? nullptr : &fragSpecializationInfo;
 
-    auto bindingDescriptions = LveModel::Vertex::getBindingDescription();
-    auto attributeDescriptions = LveModel::Vertex::getAttributeDescription();
+    auto &bindingDescriptions = configInfo.bindingDescriptions;
+    auto &attributeDescriptions = configInfo.attributeDescriptions;
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -103,7 +100,7 @@ void LvePipeline::createGraphicsPipeline(const std::string &vertFilepath, const
 
     if (vkCreateGraphicsPipelines(
             lveDevice.device(),
-            VK_NULL_HANDLE,
+            lveDevice.pipelineCache(),
             1,
             &pipelineInfo,
             nullptr,
@@ -112,13 +109,13 @@ void LvePipeline::createGraphicsPipeline(const std::string &vertFilepath, const
     }
 }
 
-void LvePipeline::createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule) {
+void LvePipeline::createShaderModule(LveDevice &device, SpirvSpan code, VkShaderModule *shaderModule) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+    createInfo.codeSize = code.wordCount * sizeof(uint32_t);
+    createInfo.pCode = code.words;
 
-    if (vkCreateShaderModule(lveDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
+    if (vkCreateShaderModule(device.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
         throw std::runtime_error("failed to create shader module!");
     }
 }
@@ -130,6 +127,9 @@ void LvePipeline::bind(VkCommandBuffer commandBuffer) {
 
 void LvePipeline::defaultPipelineConfigInfo(PipelineConfigInfo &configInfo) {
 
+    configInfo.bindingDescriptions = LveModel::Vertex::getBindingDescription();
+    configInfo.attributeDescriptions = LveModel::Vertex::getAttributeDescription();
+
     configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 
     // This tells the api vertecis  are going to be a triangle, for example not a line
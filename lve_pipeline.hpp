@@ -1,17 +1,50 @@
 #pragma once
 
 #include "lve_device.hpp"
-#include <string>
+
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace lve
 {
+    // SPIR-V words of one shader, usually one of the lve::shaders arrays embedded at build time
+    struct SpirvSpan
+    {
+        const uint32_t *words = nullptr;
+        size_t wordCount = 0;
+
+        SpirvSpan() = default;
+        SpirvSpan(const uint32_t *words, size_t wordCount) : words{words}, wordCount{wordCount} {}
+        template <size_t N>
+        SpirvSpan(const uint32_t (&array)[N]) : words{array}, wordCount{N} {}
+    };
+
+    // Specialization constants of one shader stage (layout (constant_id = N) const ...).
+    // The driver compiles them in as literals, so branches and loops on them are folded away.
+    // Every constant is 32 bits wide, which covers bool, int, uint and float.
+    struct SpecializationConstants
+    {
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<uint32_t> data;
+
+        void set(uint32_t constantId, uint32_t value);
+        void set(uint32_t constantId, int32_t value) { set(constantId, static_cast<uint32_t>(value)); }
+        void set(uint32_t constantId, bool value) { set(constantId, static_cast<uint32_t>(value ? VK_TRUE : VK_FALSE)); }
+        void set(uint32_t constantId, float value);
+        bool empty() const { return entries.empty(); }
+        // points into this object, valid as long as it is not modified
+        VkSpecializationInfo info() const;
+    };
 
     struct PipelineConfigInfo
     {
         PipelineConfigInfo(const PipelineConfigInfo &) = delete;   
         PipelineConfigInfo& operator=(const PipelineConfigInfo &) = delete; 
 
+        // vertex input layout, defaults to LveModel::Vertex
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
         VkPipelineViewportStateCreateInfo viewportInfo;
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -24,12 +57,15 @@ namespace lve
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+        // constants not set here keep the defaults written in the shader
+        SpecializationConstants vertSpecialization;
+        SpecializationConstants fragSpecialization;
     };
 
     class LvePipeline
     {
     public:
-        LvePipeline(LveDevice &device, const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
+        LvePipeline(LveDevice &device, SpirvSpan vertCode, SpirvSpan fragCode, const PipelineConfigInfo &configInfo);
 
         ~LvePipeline();
         LvePipeline(const LvePipeline &) = delete;    // not copyable
@@ -38,11 +74,10 @@ namespace lve
 
         void bind(VkCommandBuffer commandBuffer);
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+        static void createShaderModule(LveDevice &device, SpirvSpan code, VkShaderModule *shaderModule);
 
     private:
-        static std::vector<char> readFile(const std::string &filepath);
-        void createGraphicsPipeline(const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
-        void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
+        void createGraphicsPipeline(SpirvSpan vertCode, SpirvSpan fragCode, const PipelineConfigInfo &configInfo);
 
         LveDevice &lveDevice;            // reference to logical device which the pipeline will be used with
         VkPipeline graphicsPipeline;     // handle to graphics pipeline object
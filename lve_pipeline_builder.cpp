@@ -0,0 +1,30 @@
+#include "lve_pipeline_builder.hpp"
+#include "lve_trace.hpp"
+
+namespace lve {
+
+LvePipelineBuilder::Future LvePipelineBuilder::build(Factory factory) {
+    auto promise = std::make_shared<std::promise<std::shared_ptr<LvePipeline>>>();
+    Future future = promise->get_future().share();
+    auto task = [promise, factory = std::move(factory)] {
+        LveTraceZone zone{"build pipeline"};
+        try {
+            promise->set_value(factory());
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    };
+    if (pool.threadCount() == 1) {
+        // no workers, nobody would ever pick the task up before a wait()
+        task();
+    } else {
+        pool.submit(group, std::move(task));
+    }
+    return future;
+}
+
+void LvePipelineBuilder::wait() {
+    pool.wait(group);
+}
+
+} // namespace lve
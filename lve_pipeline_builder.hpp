@@ -0,0 +1,108 @@
+#pragma once
+
+#include "lve_pipeline.hpp"
+#include "lve_thread_pool.hpp"
+
+// std lib headers
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+
+namespace lve {
+
+// Compiles pipelines on the thread pool's workers, so the thread recording frames never waits for
+// the driver's shader compiler. vkCreateGraphicsPipelines may be called from any thread, the device's
+// pipeline cache is internally synchronized.
+class LvePipelineBuilder {
+public:
+    using Factory = std::function<std::unique_ptr<LvePipeline>()>;
+    using Future = std::shared_future<std::shared_ptr<LvePipeline>>;
+
+    explicit LvePipelineBuilder(LveThreadPool &pool) : pool{pool} {}
+    // waits for the builds still running, they may reference whoever started them
+    ~LvePipelineBuilder() { wait(); }
+    LvePipelineBuilder(const LvePipelineBuilder &) = delete;
+    LvePipelineBuilder &operator=(const LvePipelineBuilder &) = delete;
+
+    // runs factory on a worker, the future holds the pipeline or the exception it threw
+    Future build(Factory factory);
+    // helps building until every pipeline started so far is done
+    void wait();
+
+private:
+    LveThreadPool &pool;
+    LveThreadPool::TaskGroup group;
+};
+
+// Pipeline variants of one render system, e.g. one per combination of specialization constants.
+// Without a builder get() compiles a variant the first time its key is asked for. With a builder
+// tryGet() starts compiling it in the background and returns nullptr until it is ready, so the
+// caller can keep drawing with a variant it already has.
+template <typename Key>
+class LvePipelineVariants {
+public:
+    using Factory = std::function<std::unique_ptr<LvePipeline>(const Key &)>;
+
+    explicit LvePipelineVariants(Factory factory, LvePipelineBuilder *builder = nullptr)
+        : factory{std::move(factory)}, builder{builder} {}
+    ~LvePipelineVariants() { wait(); }
+    LvePipelineVariants(const LvePipelineVariants &) = delete;
+    LvePipelineVariants &operator=(const LvePipelineVariants &) = delete;
+
+    // blocks until the variant is built
+    LvePipeline &get(const Key &key) {
+        if (LvePipeline *pipeline = tryGet(key)) {
+            return *pipeline;
+        }
+        auto &entry = variants[key];
+        builder->wait();
+        entry.pipeline = entry.future.get();
+        return *entry.pipeline;
+    }
+
+    // the variant if it is ready, otherwise starts building it (only once) and returns nullptr
+    LvePipeline *tryGet(const Key &key) {
+        auto &entry = variants[key];
+        if (entry.pipeline) {
+            return entry.pipeline.get();
+        }
+        if (builder == nullptr) {
+            entry.pipeline = factory(key);
+            return entry.pipeline.get();
+        }
+        if (!entry.future.valid()) {
+            entry.future = builder->build([this, key] { return factory(key); });
+        }
+        if (entry.future.wait_for(std::chrono::seconds{0}) == std::future_status::ready) {
+            // rethrows if the build failed
+            entry.pipeline = entry.future.get();
+            return entry.pipeline.get();
+        }
+        return nullptr;
+    }
+
+    // waits for the variants still being built, their factories may use the owner's members
+    void wait() {
+        for (auto &variant : variants) {
+            if (!variant.second.pipeline && variant.second.future.valid()) {
+                variant.second.future.wait();
+            }
+        }
+    }
+
+    size_t size() const { return variants.size(); }
+
+private:
+    struct Entry {
+        std::shared_ptr<LvePipeline> pipeline;
+        LvePipelineBuilder::Future future;
+    };
+
+    Factory factory;
+    LvePipelineBuilder *builder;
+    std::map<Key, Entry> variants;
+};
+
+} // namespace lve
@@ -0,0 +1,168 @@
+#include "lve_pipeline_cache.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace lve {
+
+namespace {
+
+constexpr char MAGIC[8] = {'L', 'V', 'E', 'P', 'C', 'A', 'C', 'H'};
+constexpr uint32_t FILE_VERSION = 1;
+
+} // namespace
+
+LvePipelineCache::LvePipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties)
+    : device{device}, properties{properties} {
+    std::ostringstream name;
+    name << "pipeline_cache_" << std::hex << properties.vendorID << "_" << properties.deviceID << "_"
+         << properties.driverVersion << "_";
+    for (uint8_t byte : properties.pipelineCacheUUID) {
+        name << (byte >> 4) << (byte & 0xF);
+    }
+    name << ".bin";
+    filePath = (std::filesystem::path{cacheDirectory()} / name.str()).string();
+
+    std::vector<char> data;
+    std::ifstream file{filePath, std::ios::binary | std::ios::ate};
+    if (file) {
+        auto fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize > sizeof(FileHeader)) {
+            FileHeader header{};
+            file.seekg(0);
+            file.read(reinterpret_cast<char *>(&header), sizeof(header));
+            data.resize(fileSize - sizeof(FileHeader));
+            file.read(data.data(), data.size());
+
+            FileHeader expected = makeHeader(data.size(), hash(data.data(), data.size()));
+            bool valid = file && std::memcmp(header.magic, expected.magic, sizeof(MAGIC)) == 0 &&
+                         header.version == expected.version && header.vendorID == expected.vendorID &&
+                         header.deviceID == expected.deviceID && header.driverVersion == expected.driverVersion &&
+                         std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0 &&
+                         header.dataSize == expected.dataSize && header.dataHash == expected.dataHash &&
+                         isCompatible(data.data(), data.size());
+            if (!valid) {
+                std::cout << "pipeline cache: ignoring stale or damaged " << filePath << std::endl;
+                data.clear();
+            }
+        }
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+    if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+        // the driver may still reject data that passed our checks, an empty cache always works
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        data.clear();
+        if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline cache");
+        }
+    }
+    loadedSize = data.size();
+    savedSize = loadedSize;
+    if (wasLoaded()) {
+        std::cout << "pipeline cache: loaded " << loadedSize / 1024 << " KiB from " << filePath << std::endl;
+    }
+}
+
+LvePipelineCache::~LvePipelineCache() {
+    save();
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+void LvePipelineCache::save() {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device, cache, &size, nullptr) != VK_SUCCESS || size <= savedSize) {
+        return;
+    }
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS) {
+        return;
+    }
+    data.resize(size);
+    FileHeader header = makeHeader(data.size(), hash(data.data(), data.size()));
+
+    // written next to the final file and renamed over it, so other processes starting at the same
+    // time never read a half written cache
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path{filePath}.parent_path(), error);
+    std::string tempPath =
+        filePath + ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(data.data(), data.size());
+        if (!file) {
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, filePath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return;
+    }
+    savedSize = data.size();
+}
+
+std::string LvePipelineCache::cacheDirectory() {
+    if (const char *dir = std::getenv("LVE_PIPELINE_CACHE_DIR")) {
+        return dir;
+    }
+    if (const char *dir = std::getenv("XDG_CACHE_HOME")) {
+        return (std::filesystem::path{dir} / "lve").string();
+    }
+    if (const char *home = std::getenv("HOME")) {
+        return (std::filesystem::path{home} / ".cache" / "lve").string();
+    }
+    return ".";
+}
+
+uint64_t LvePipelineCache::hash(const char *data, size_t size) {
+    // fnv-1a, only has to catch truncated or damaged files
+    uint64_t value = 14695981039346656037ull;
+    for (size_t i = 0; i < size; i++) {
+        value ^= static_cast<uint8_t>(data[i]);
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+bool LvePipelineCache::isCompatible(const char *data, size_t size) const {
+    // VkPipelineCacheHeaderVersionOne: header size, header version, vendor id, device id, uuid
+    constexpr size_t VULKAN_HEADER_SIZE = 16 + VK_UUID_SIZE;
+    if (size < VULKAN_HEADER_SIZE) {
+        return false;
+    }
+    uint32_t fields[4];
+    std::memcpy(fields, data, sizeof(fields));
+    return fields[0] >= VULKAN_HEADER_SIZE && fields[0] <= size &&
+           fields[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && fields[2] == properties.vendorID &&
+           fields[3] == properties.deviceID &&
+           std::memcmp(data + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+LvePipelineCache::FileHeader LvePipelineCache::makeHeader(size_t dataSize, uint64_t dataHash) const {
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FILE_VERSION;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = dataSize;
+    header.dataHash = dataHash;
+    return header;
+}
+
+} // namespace lve
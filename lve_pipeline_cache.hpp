@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+// A VkPipelineCache that survives restarts, so pipelines only go through the driver's shader
+// compiler on the first launch on a machine.
+// The cache lives in one file per gpu and driver: the name contains vendor id, device id, driver
+// version and pipelineCacheUUID, and the file starts with our own header repeating them plus the
+// size and a hash of the data. Anything that doesn't match (other driver, truncated or corrupt
+// file, a vulkan header for another device) is ignored and the cache starts empty.
+// The file goes to $LVE_PIPELINE_CACHE_DIR, else $XDG_CACHE_HOME/lve, else ~/.cache/lve.
+class LvePipelineCache {
+public:
+    LvePipelineCache(VkDevice device, const VkPhysicalDeviceProperties &properties);
+    // saves the cache
+    ~LvePipelineCache();
+    LvePipelineCache(const LvePipelineCache &) = delete;
+    LvePipelineCache &operator=(const LvePipelineCache &) = delete;
+
+    // pass to vkCreate*Pipelines, the cache is internally synchronized so any thread may use it
+    VkPipelineCache handle() const { return cache; }
+    const std::string &path() const { return filePath; }
+    // true when the previous contents were found and accepted
+    bool wasLoaded() const { return loadedSize > 0; }
+
+    // writes the cache if it grew since it was loaded or last saved; never throws, a cache that
+    // can't be written only costs the next start some compile time
+    void save();
+
+private:
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t dataSize;
+        uint64_t dataHash;
+    };
+
+    static std::string cacheDirectory();
+    static uint64_t hash(const char *data, size_t size);
+    // the vulkan header at the start of the cache data has to describe this device as well
+    bool isCompatible(const char *data, size_t size) const;
+    FileHeader makeHeader(size_t dataSize, uint64_t dataHash) const;
+
+    VkDevice device;
+    VkPhysicalDeviceProperties properties;
+    std::string filePath;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    size_t loadedSize = 0;
+    size_t savedSize = 0;
+};
+
+} // namespace lve
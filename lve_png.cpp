@@ -0,0 +1,132 @@
+#include "lve_png.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace lve {
+
+namespace {
+
+// a stored deflate block holds at most 65535 bytes
+constexpr size_t MAX_STORED_BLOCK = 65535;
+
+const std::array<uint32_t, 256> &crcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[n] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+void putU32(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void putChunk(std::vector<uint8_t> &out, const char *type, const std::vector<uint8_t> &data) {
+    putU32(out, static_cast<uint32_t>(data.size()));
+    size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    // the crc covers the chunk type and data, not the length
+    putU32(out, LvePngWriter::crc32(0, out.data() + typeStart, out.size() - typeStart));
+}
+
+} // namespace
+
+uint32_t LvePngWriter::crc32(uint32_t crc, const uint8_t *data, size_t size) {
+    const auto &table = crcTable();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t LvePngWriter::adler32(uint32_t adler, const uint8_t *data, size_t size) {
+    // 5552 is the largest n for which the sums can't overflow 32 bits before the modulo
+    constexpr uint32_t MOD = 65521;
+    constexpr size_t NMAX = 5552;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        size_t n = size < NMAX ? size : NMAX;
+        size -= n;
+        for (size_t i = 0; i < n; i++) {
+            a += data[i];
+            b += a;
+        }
+        data += n;
+        a %= MOD;
+        b %= MOD;
+    }
+    return (b << 16) | a;
+}
+
+std::vector<uint8_t> LvePngWriter::encode(uint32_t width, uint32_t height, const uint8_t *rgba) {
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    // every row starts with its filter type, 0 = none
+    std::vector<uint8_t> scanlines((rowSize + 1) * height);
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t *row = scanlines.data() + y * (rowSize + 1);
+        row[0] = 0;
+        std::memcpy(row + 1, rgba + y * rowSize, rowSize);
+    }
+
+    std::vector<uint8_t> zlib;
+    zlib.reserve(scanlines.size() + scanlines.size() / MAX_STORED_BLOCK * 5 + 16);
+    // deflate, 32K window, no dictionary, fastest level; 0x78 0x01 is a multiple of 31 as required
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    size_t remaining = scanlines.size();
+    const uint8_t *data = scanlines.data();
+    do {
+        size_t blockSize = remaining < MAX_STORED_BLOCK ? remaining : MAX_STORED_BLOCK;
+        remaining -= blockSize;
+        zlib.push_back(remaining == 0 ? 1 : 0); // BFINAL, BTYPE = 00 (stored)
+        zlib.push_back(static_cast<uint8_t>(blockSize));
+        zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+        zlib.push_back(static_cast<uint8_t>(~blockSize));
+        zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        zlib.insert(zlib.end(), data, data + blockSize);
+        data += blockSize;
+    } while (remaining > 0);
+    putU32(zlib, adler32(1, scanlines.data(), scanlines.size()));
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    png.reserve(zlib.size() + 64);
+
+    std::vector<uint8_t> header;
+    putU32(header, width);
+    putU32(header, height);
+    header.push_back(8); // bit depth
+    header.push_back(6); // color type: rgba
+    header.push_back(0); // compression: deflate
+    header.push_back(0); // filter method
+    header.push_back(0); // no interlace
+    putChunk(png, "IHDR", header);
+    putChunk(png, "IDAT", zlib);
+    putChunk(png, "IEND", {});
+    return png;
+}
+
+void LvePngWriter::write(const std::string &path, uint32_t width, uint32_t height, const uint8_t *rgba) {
+    std::vector<uint8_t> png = encode(width, height, rgba);
+    std::ofstream file{path, std::ios::binary};
+    if (!file.write(reinterpret_cast<const char *>(png.data()), png.size())) {
+        throw std::runtime_error("failed to write png: " + path);
+    }
+}
+
+} // namespace lve
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve {
+
+// Minimal PNG encoder for 8 bit RGBA images, enough to dump frames without pulling in a library.
+// The image data goes into stored (uncompressed) deflate blocks, so the files are about as large as
+// the raw pixels, in exchange encoding is a memcpy plus two checksums and keeps up with the gpu.
+class LvePngWriter {
+public:
+    // rgba: height rows of width * 4 bytes, top row first
+    static std::vector<uint8_t> encode(uint32_t width, uint32_t height, const uint8_t *rgba);
+    static void write(const std::string &path, uint32_t width, uint32_t height, const uint8_t *rgba);
+
+    static uint32_t crc32(uint32_t crc, const uint8_t *data, size_t size);
+    static uint32_t adler32(uint32_t adler, const uint8_t *data, size_t size);
+};
+
+} // namespace lve
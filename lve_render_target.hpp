@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+namespace lve {
+
+// What LveRenderer draws into: the window's LveSwapChain or an LveOffscreenTarget.
+// A frame is acquireNextImage() -> record into getFrameBuffer(imageIndex) -> submitCommandBuffers(),
+// with up to getFramesInFlight() frames on the gpu at once.
+class LveRenderTarget {
+public:
+    virtual ~LveRenderTarget() = default;
+
+    virtual VkRenderPass getRenderPass() = 0;
+    virtual VkFramebuffer getFrameBuffer(int index) = 0;
+    virtual VkExtent2D getExtent() = 0;
+    virtual int getFramesInFlight() const = 0;
+
+    // waits until the next frame slot is free, then picks the image to render into
+    virtual VkResult acquireNextImage(uint32_t *imageIndex) = 0;
+    virtual VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) = 0;
+    // blocks until every submitted frame has finished on the gpu
+    virtual void waitForFrames() = 0;
+    // seconds the cpu spent blocked on fences (and image acquisition) in the last acquireNextImage or submitCommandBuffers call
+    virtual double getLastWaitTime() const = 0;
+};
+
+} // namespace lve
@@ -1,36 +1,73 @@
 #include "lve_renderer.hpp"
+#include "lve_trace.hpp"
 
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
 namespace lve {
 
-LveRenderer::LveRenderer(LveWindow &window, LveDevice &device) : lveWindow{window}, lveDevice{device} {
+LveRenderer::LveRenderer(LveWindow &window, LveDevice &device, int framesInFlight)
+    : lveWindow{&window}, lveDevice{device}, gpuProfiler{device, framesInFlight}, framesInFlight{framesInFlight} {
     recreateSwapChain();
     createCommandBuffers();
 }
 
+LveRenderer::LveRenderer(LveDevice &device, VkExtent2D extent, int framesInFlight)
+    : lveDevice{device}, gpuProfiler{device, framesInFlight}, framesInFlight{framesInFlight} {
+    auto target = std::make_unique<LveOffscreenTarget>(lveDevice, extent, framesInFlight);
+    offscreenTarget = target.get();
+    renderTarget = std::move(target);
+    createCommandBuffers();
+}
+
 LveRenderer::~LveRenderer() {
+    vkDeviceWaitIdle(lveDevice.device());
+    completedFrames = frameNumber + 1;
+    collectRetired();
     freeCommandBuffers();
 }
 
+void LveRenderer::retire(std::function<void()> destroy) {
+    retirementQueue.push_back({frameNumber, std::move(destroy)});
+}
+
+void LveRenderer::collectRetired() {
+    // batched: everything that became free since the last frame goes at once
+    while (!retirementQueue.empty() && retirementQueue.front().frame < completedFrames) {
+        auto destroy = std::move(retirementQueue.front().destroy);
+        retirementQueue.pop_front();
+        destroy();
+    }
+}
+
 void LveRenderer::recreateSwapChain() {
-    auto extent = lveWindow.getExtend();
+    // offscreen targets never go out of date
+    assert(lveWindow != nullptr && "Only a window's swap chain can be recreated");
+    auto extent = lveWindow->getExtend();
     while (extent.width == 0 || extent.height == 0) {
-        extent = lveWindow.getExtend();
+        extent = lveWindow->getExtend();
         glfwWaitEvents();
     }
-    vkDeviceWaitIdle(lveDevice.device());
 
-    if (lveSwapChain == nullptr) {
-        lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent);
+    if (renderTarget == nullptr) {
+        renderTarget = std::make_unique<LveSwapChain>(lveDevice, extent, framesInFlight);
     } else {
-        std::shared_ptr<LveSwapChain> oldSwapChain = std::move(lveSwapChain);
-        lveSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain);
-        if(!oldSwapChain->compareSwapFormats(*lveSwapChain.get())){
+        // with a window the render target is always the swap chain
+        std::shared_ptr<LveSwapChain> oldSwapChain{static_cast<LveSwapChain *>(renderTarget.release())};
+        // The command buffers are reused by frame index and the fences of the new swap chain know
+        // nothing about the frames of the old one, so those frames have to finish first.
+        // That waits for our own frames only, not for the whole device.
+        oldSwapChain->waitForFrames();
+        completedFrames = frameNumber;
+        auto newSwapChain = std::make_unique<LveSwapChain>(lveDevice, extent, oldSwapChain, framesInFlight);
+        if(!oldSwapChain->compareSwapFormats(*newSwapChain)){
             throw std::runtime_error("Swap chain image (or depth) format has changed");
         }
+        renderTarget = std::move(newSwapChain);
+        // the presentation engine may still be showing its images, it goes away after the next frame
+        retire(std::move(oldSwapChain));
     }
 }
 
@@ -41,7 +78,8 @@ void LveRenderer::createCommandBuffers() {
     // apple silicone m1 and m2 supports triple buffering
 
     // each command buffer is going to draw to a different frame buffer here
-    commandBuffers.resize(LveSwapChain::MAX_FRAMES_IN_FLIGHT);
+    // one per frame in flight, a command buffer is reused once its frame's fence has signaled
+    commandBuffers.resize(framesInFlight);
 
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -66,8 +104,16 @@ void LveRenderer::freeCommandBuffers() {
 
 VkCommandBuffer LveRenderer::beginFrame() {
     assert(!isFrameStarted && "Can't call beginFrame while already in progress");
-
-    auto result = lveSwapChain->acquireNextImage(&currentImageIndex);
+    LveTraceZone zone{"beginFrame"};
+
+    auto result = renderTarget->acquireNextImage(&currentImageIndex);
+    gpuWaitTime += renderTarget->getLastWaitTime();
+    // acquireNextImage waited for the fence of the frame that used this frame slot last,
+    // fences signal in submission order so every frame before it is done as well
+    if (frameNumber >= static_cast<uint64_t>(framesInFlight)) {
+        completedFrames = std::max(completedFrames, frameNumber - framesInFlight + 1);
+    }
+    collectRetired();
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateSwapChain();
@@ -85,18 +131,23 @@ VkCommandBuffer LveRenderer::beginFrame() {
     if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to being recording command buffer");
     }
+    // the fence of this frame slot has signaled, so its previous timestamps can be read back
+    gpuProfiler.beginFrame(commandBuffer, currentFrameIndex);
     return commandBuffer;
 }
 void LveRenderer::endFrame() {
     assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
+    LveTraceZone zone{"endFrame"};
     auto commandBuffer = getCurrentCommandBuffer();
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer");
     }
 
-    auto result = lveSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lveWindow.wasWindowResized()) {
-        lveWindow.resetWindowResizeFlag();
+    auto result = renderTarget->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+    gpuWaitTime += renderTarget->getLastWaitTime();
+    frameNumber++;
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || (lveWindow && lveWindow->wasWindowResized())) {
+        lveWindow->resetWindowResizeFlag();
         recreateSwapChain();
     }
 
@@ -104,18 +155,18 @@ void LveRenderer::endFrame() {
         throw std::runtime_error("failed to present swap chain image");
     }
     isFrameStarted = false;
-    currentFrameIndex = (currentFrameIndex+1) % LveSwapChain::MAX_FRAMES_IN_FLIGHT;
+    currentFrameIndex = (currentFrameIndex+1) % framesInFlight;
 }
-void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
     assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
     assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame");
 
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = lveSwapChain->getRenderPass();
-    renderPassInfo.framebuffer = lveSwapChain->getFrameBuffer(currentImageIndex);
+    renderPassInfo.renderPass = renderTarget->getRenderPass();
+    renderPassInfo.framebuffer = renderTarget->getFrameBuffer(currentImageIndex);
     renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = lveSwapChain->getSwapChainExtent();
+    renderPassInfo.renderArea.extent = renderTarget->getExtent();
 
     std::array<VkClearValue, 2> clearValues{};
     // in the render pass attachments are structured with index
@@ -127,7 +178,8 @@ void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    renderPassScope = gpuProfiler.beginScope(commandBuffer, "render pass");
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
 
     /*
     --inline:
@@ -149,15 +201,19 @@ void LveRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
 
     You can't mix these to ways.
     */
+    if (contents != VK_SUBPASS_CONTENTS_INLINE) {
+        // only vkCmdExecuteCommands is allowed in the primary now, dynamic state isn't inherited anyway
+        return;
+    }
 
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
-    viewport.width = static_cast<float>(lveSwapChain->getSwapChainExtent().width);
-    viewport.height = static_cast<float>(lveSwapChain->getSwapChainExtent().height);
+    viewport.width = static_cast<float>(renderTarget->getExtent().width);
+    viewport.height = static_cast<float>(renderTarget->getExtent().height);
     viewport.minDepth = 0.0f;
     viewport.maxDepth = 1.0f;
-    VkRect2D scissor{{0, 0}, lveSwapChain->getSwapChainExtent()};
+    VkRect2D scissor{{0, 0}, renderTarget->getExtent()};
     vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
@@ -166,6 +222,7 @@ void LveRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
      assert(isFrameStarted && "Can't call endSwapChainRenderPass if frame is not in progress");
     assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer from a different frame");
     vkCmdEndRenderPass(commandBuffer);
+    gpuProfiler.endScope(commandBuffer, renderPassScope);
 
 }
 
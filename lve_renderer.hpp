@@ -1,10 +1,16 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_offscreen_target.hpp"
+#include "lve_render_target.hpp"
 #include "lve_swap_chain.hpp"
 #include "lve_window.hpp"
 
 #include <cassert>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -13,12 +19,22 @@ namespace lve {
 
     class LveRenderer {
         public:
-        LveRenderer(LveWindow& window, LveDevice& device);
+        // framesInFlight: 1 .. LveSwapChain::MAX_FRAMES_IN_FLIGHT frames the cpu may record ahead of the gpu
+        LveRenderer(LveWindow& window, LveDevice& device, int framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
+        // headless: renders into an LveOffscreenTarget of the given size, same frame api as with a window
+        LveRenderer(LveDevice& device, VkExtent2D extent, int framesInFlight = LveSwapChain::DEFAULT_FRAMES_IN_FLIGHT);
         ~LveRenderer();
         LveRenderer(const LveRenderer&) = delete;
         LveRenderer& operator=(const LveRenderer&) = delete;
 
-        VkRenderPass getSwapChainRenderPass() const { return lveSwapChain->getRenderPass();}
+        VkRenderPass getSwapChainRenderPass() const { return renderTarget->getRenderPass();}
+        bool isHeadless() const { return lveWindow == nullptr; }
+        // only set for headless renderers
+        LveOffscreenTarget* getOffscreenTarget() const { return offscreenTarget; }
+        // the image the current (or, after endFrame, the last) frame renders into
+        uint32_t getCurrentImageIndex() const { return currentImageIndex; }
+        VkFramebuffer getCurrentFramebuffer() const { return renderTarget->getFrameBuffer(currentImageIndex); }
+        VkExtent2D getExtent() const { return renderTarget->getExtent(); }
         bool isFrameInProgress() const {return isFrameStarted;}
 
         VkCommandBuffer getCurrentCommandBuffer() const {
@@ -28,27 +44,74 @@ namespace lve {
 
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS when the draws are recorded into
+        // secondary command buffers (see LveParallelRecorder), those set their own viewport and scissor
+        void beginSwapChainRenderPass(
+            VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
         int getFrameIndex() const {
             assert(isFrameStarted&&"Cannot get frame index when frame not in progress");
             return currentFrameIndex;
         }
+        int getFramesInFlight() const { return framesInFlight; }
+        // gpu timings of the render pass (and of whatever the render systems scope inside it)
+        LveGpuProfiler& getGpuProfiler() { return gpuProfiler; }
+
+        // Deferred destruction: frames that are still in flight may use a resource that the cpu is
+        // done with, so instead of destroying it right away it is handed to the renderer, which runs
+        // the function once every frame submitted so far (and the one being recorded) has finished.
+        // Works for buffers, memory, pipelines or anything else, and never stalls the frame loop.
+        void retire(std::function<void()> destroy);
+        // keeps the object alive until the frames in flight are done with it
+        template <typename T>
+        void retire(std::shared_ptr<T> resource) {
+            if (resource) {
+                retire([resource = std::move(resource)]() mutable { resource.reset(); });
+            }
+        }
+        size_t retiredCount() const { return retirementQueue.size(); }
+
+        // seconds the cpu was blocked waiting for the gpu (frame fences and image acquisition)
+        // since the last call, everything else is time the cpu worked in parallel with the gpu
+        double takeGpuWaitTime() {
+            double time = gpuWaitTime;
+            gpuWaitTime = 0.0;
+            return time;
+        }
         
     private:
 
         void createCommandBuffers();
         void freeCommandBuffers();
         void recreateSwapChain();
+        // destroys everything retired by frames that have completed
+        void collectRetired();
 
-        LveWindow& lveWindow;
+        LveWindow* lveWindow = nullptr;
         LveDevice& lveDevice;
-        std::unique_ptr<LveSwapChain> lveSwapChain;
+        // the window's LveSwapChain, or an LveOffscreenTarget without a window
+        std::unique_ptr<LveRenderTarget> renderTarget;
+        LveOffscreenTarget* offscreenTarget = nullptr;
         std::vector<VkCommandBuffer> commandBuffers;
+        LveGpuProfiler gpuProfiler;
+        uint32_t renderPassScope = UINT32_MAX;
+
+        uint32_t currentImageIndex = 0;
+        int currentFrameIndex = 0;
+        int framesInFlight;
+        double gpuWaitTime = 0.0;
 
-        uint32_t currentImageIndex;
-        int currentFrameIndex;
+        struct RetiredResource {
+            uint64_t frame; // the resource may be used up to and including this frame
+            std::function<void()> destroy;
+        };
+        // ordered by frame, since frames only count up
+        std::deque<RetiredResource> retirementQueue;
+        // frames submitted so far, also the number of the frame being recorded
+        uint64_t frameNumber = 0;
+        // frames 0 .. completedFrames - 1 have finished on the gpu
+        uint64_t completedFrames = 0;
         bool isFrameStarted = false; // not sure about that. Check that later
     
     };
@@ -1,7 +1,9 @@
 #include "lve_swap_chain.hpp"
+#include "lve_trace.hpp"
 
 // std
 #include <array>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -11,13 +13,14 @@
 
 namespace lve {
 
-LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent)
-    : device{deviceRef}, windowExtent{extent} {
+LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent, int framesInFlight)
+    : device{deviceRef}, windowExtent{extent}, framesInFlight{framesInFlight} {
     init();
 }
 
-LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent, std::shared_ptr<LveSwapChain> previous)
-    : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
+LveSwapChain::LveSwapChain(
+    LveDevice &deviceRef, VkExtent2D extent, std::shared_ptr<LveSwapChain> previous, int framesInFlight)
+    : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous}, framesInFlight{framesInFlight} {
     init();
 
     //clean up old swap chain since it's no longer needed
@@ -26,6 +29,9 @@ LveSwapChain::LveSwapChain(LveDevice &deviceRef, VkExtent2D extent, std::shared_
 }
 
 void LveSwapChain::init() {
+    if (framesInFlight < 1 || framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+        throw std::runtime_error("frames in flight must be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+    }
     createSwapChain();
     createImageViews();
     createRenderPass();
@@ -48,7 +54,7 @@ LveSwapChain::~LveSwapChain() {
     for (int i = 0; i < depthImages.size(); i++) {
         vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
         vkDestroyImage(device.device(), depthImages[i], nullptr);
-        vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+        device.allocator().free(depthImageMemorys[i]);
     }
 
     for (auto framebuffer : swapChainFramebuffers) {
@@ -58,7 +64,7 @@ LveSwapChain::~LveSwapChain() {
     vkDestroyRenderPass(device.device(), renderPass, nullptr);
 
     // cleanup synchronization objects
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < inFlightFences.size(); i++) {
         vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
         vkDestroyFence(device.device(), inFlightFences[i], nullptr);
@@ -66,13 +72,20 @@ LveSwapChain::~LveSwapChain() {
 }
 
 VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex) {
-    vkWaitForFences(
-        device.device(),
-        1,
-        &inFlightFences[currentFrame],
-        VK_TRUE,
-        std::numeric_limits<uint64_t>::max());
+    // this is where the cpu waits for the gpu: the frame slot is free once the gpu is done with
+    // the frame submitted framesInFlight frames ago
+    auto waitStart = std::chrono::steady_clock::now();
+    {
+        LveTraceZone zone{"wait frame fence"};
+        vkWaitForFences(
+            device.device(),
+            1,
+            &inFlightFences[currentFrame],
+            VK_TRUE,
+            std::numeric_limits<uint64_t>::max());
+    }
 
+    LveTraceZone zone{"acquire image"};
     VkResult result = vkAcquireNextImageKHR(
         device.device(),
         swapChain,
@@ -81,13 +94,19 @@ VkResult LveSwapChain::acquireNextImage(uint32_t *imageIndex) {
         VK_NULL_HANDLE,
         imageIndex);
 
+    lastWaitTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
     return result;
 }
 
 VkResult LveSwapChain::submitCommandBuffers(
     const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+    lastWaitTime = 0.0;
     if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+        // with more frames in flight than swap chain images, the image itself may still be in use
+        auto waitStart = std::chrono::steady_clock::now();
+        LveTraceZone zone{"wait image fence"};
         vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
+        lastWaitTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
     }
     imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
@@ -108,9 +127,12 @@ VkResult LveSwapChain::submitCommandBuffers(
     submitInfo.pSignalSemaphores = signalSemaphores;
 
     vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-        VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        LveTraceZone zone{"submit"};
+        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
     }
 
     VkPresentInfoKHR presentInfo = {};
@@ -125,13 +147,23 @@ VkResult LveSwapChain::submitCommandBuffers(
 
     presentInfo.pImageIndices = imageIndex;
 
+    LveTraceZone zone{"present"};
     auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    currentFrame = (currentFrame + 1) % framesInFlight;
 
     return result;
 }
 
+void LveSwapChain::waitForFrames() {
+    vkWaitForFences(
+        device.device(),
+        static_cast<uint32_t>(inFlightFences.size()),
+        inFlightFences.data(),
+        VK_TRUE,
+        std::numeric_limits<uint64_t>::max());
+}
+
 void LveSwapChain::createSwapChain() {
     SwapChainSupportDetails swapChainSupport = device.getSwapChainSupport();
 
@@ -350,9 +382,9 @@ void LveSwapChain::createDepthResources() {
 }
 
 void LveSwapChain::createSyncObjects() {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAvailableSemaphores.resize(framesInFlight);
+    renderFinishedSemaphores.resize(framesInFlight);
+    inFlightFences.resize(framesInFlight);
     imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
@@ -362,7 +394,7 @@ void LveSwapChain::createSyncObjects() {
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < inFlightFences.size(); i++) {
         if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
                 VK_SUCCESS ||
             vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
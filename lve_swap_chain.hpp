@@ -1,6 +1,7 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_render_target.hpp"
 
 // vulkan headers
 #include <vulkan/vulkan.h>
@@ -11,33 +12,43 @@
 
 namespace lve {
 
-class LveSwapChain {
+class LveSwapChain : public LveRenderTarget {
  public:
-  static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent);
-  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, std::shared_ptr<LveSwapChain> previous);
-  ~LveSwapChain();
+  // frames the cpu may record ahead of the gpu, picked at runtime between 1 and MAX_FRAMES_IN_FLIGHT
+  static constexpr int MAX_FRAMES_IN_FLIGHT = 4;
+  static constexpr int DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+  LveSwapChain(LveDevice &deviceRef, VkExtent2D windowExtent, int framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
+  LveSwapChain(
+      LveDevice &deviceRef,
+      VkExtent2D windowExtent,
+      std::shared_ptr<LveSwapChain> previous,
+      int framesInFlight = DEFAULT_FRAMES_IN_FLIGHT);
+  ~LveSwapChain() override;
 
   LveSwapChain(const LveSwapChain &) = delete;
   LveSwapChain& operator=(const LveSwapChain &) = delete;
 
-  VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-  VkRenderPass getRenderPass() { return renderPass; }
+  VkFramebuffer getFrameBuffer(int index) override { return swapChainFramebuffers[index]; }
+  VkRenderPass getRenderPass() override { return renderPass; }
   VkImageView getImageView(int index) { return swapChainImageViews[index]; }
   size_t imageCount() { return swapChainImages.size(); }
   VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
+  VkExtent2D getExtent() override { return swapChainExtent; }
   uint32_t width() { return swapChainExtent.width; }
   uint32_t height() { return swapChainExtent.height; }
+  int getFramesInFlight() const override { return framesInFlight; }
+  double getLastWaitTime() const override { return lastWaitTime; }
 
   float extentAspectRatio() {
     return static_cast<float>(swapChainExtent.width) / static_cast<float>(swapChainExtent.height);
   }
   VkFormat findDepthFormat();
 
-  VkResult acquireNextImage(uint32_t *imageIndex);
-  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+  VkResult acquireNextImage(uint32_t *imageIndex) override;
+  VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex) override;
+  void waitForFrames() override;
 
   bool compareSwapFormats(const LveSwapChain& swapChain) const {
     // if they both are the same render pass must be compatible
@@ -68,7 +79,7 @@ class LveSwapChain {
   VkRenderPass renderPass;
 
   std::vector<VkImage> depthImages;
-  std::vector<VkDeviceMemory> depthImageMemorys;
+  std::vector<LveAllocation> depthImageMemorys;
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
@@ -84,6 +95,8 @@ class LveSwapChain {
   std::vector<VkFence> inFlightFences;
   std::vector<VkFence> imagesInFlight;
   size_t currentFrame = 0;
+  int framesInFlight;
+  double lastWaitTime = 0.0;
 };
 
 }  // namespace lve
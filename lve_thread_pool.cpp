@@ -0,0 +1,128 @@
+#include "lve_thread_pool.hpp"
+
+#include <algorithm>
+
+namespace lve {
+
+namespace {
+// lets a task know which queue it should push its subtasks to
+thread_local const LveThreadPool *currentPool = nullptr;
+thread_local unsigned currentQueue = 0;
+} // namespace
+
+LveThreadPool::LveThreadPool(unsigned threadCount) {
+    threadCount = std::max(threadCount, 1u);
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 1; i < threadCount; i++) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+LveThreadPool::~LveThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{sleepMutex};
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned LveThreadPool::currentQueueIndex() const {
+    return currentPool == this ? currentQueue : 0;
+}
+
+void LveThreadPool::submit(TaskGroup &group, std::function<void()> task) {
+    group.pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        auto &queue = *queues[currentQueueIndex()];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        queue.tasks.push_back({std::move(task), &group});
+    }
+    {
+        // the increment happens under the sleep mutex so a worker can't miss the wake up
+        // between checking queuedTasks and going to sleep
+        std::lock_guard<std::mutex> lock{sleepMutex};
+        queuedTasks.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeUp.notify_one();
+}
+
+void LveThreadPool::wait(TaskGroup &group) {
+    unsigned queueIndex = currentQueueIndex();
+    while (group.pending.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (tryPop(queueIndex, task)) {
+            execute(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock{group.errorMutex};
+    if (group.error) {
+        auto error = group.error;
+        group.error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool LveThreadPool::tryPop(unsigned queueIndex, Task &task) {
+    {
+        // own queue first, newest task
+        auto &queue = *queues[queueIndex];
+        std::lock_guard<std::mutex> lock{queue.mutex};
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    // then steal the oldest task of someone else
+    for (size_t i = 1; i < queues.size(); i++) {
+        auto &victim = *queues[(queueIndex + i) % queues.size()];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void LveThreadPool::execute(Task &task) {
+    try {
+        task.function();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock{task.group->errorMutex};
+        if (!task.group->error) {
+            task.group->error = std::current_exception();
+        }
+    }
+    task.group->pending.fetch_sub(1, std::memory_order_release);
+}
+
+void LveThreadPool::workerLoop(unsigned queueIndex) {
+    currentPool = this;
+    currentQueue = queueIndex;
+    while (true) {
+        Task task;
+        if (tryPop(queueIndex, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{sleepMutex};
+        wakeUp.wait(lock, [this] { return stopping || queuedTasks.load(std::memory_order_relaxed) > 0; });
+        if (stopping && queuedTasks.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+    }
+}
+
+} // namespace lve
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lve {
+
+// Work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own work at the back (LIFO keeps the
+// recently split, cache-hot subtrees on the same core) and idle workers steal from the front
+// of other deques (FIFO hands out the biggest, oldest chunks of work).
+// The thread that calls wait() also executes tasks, so a pool created with threadCount = N
+// keeps N threads busy while it starts only N - 1 workers.
+class LveThreadPool {
+public:
+    // Tasks are tracked per group so different systems can share one pool and wait only for their own work.
+    class TaskGroup {
+    public:
+        TaskGroup() = default;
+        TaskGroup(const TaskGroup &) = delete;
+        TaskGroup &operator=(const TaskGroup &) = delete;
+
+    private:
+        friend class LveThreadPool;
+        std::atomic<size_t> pending{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+
+    explicit LveThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+    ~LveThreadPool();
+    LveThreadPool(const LveThreadPool &) = delete;
+    LveThreadPool &operator=(const LveThreadPool &) = delete;
+
+    // number of threads taking part in the work, including the one that waits
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    void submit(TaskGroup &group, std::function<void()> task);
+    // runs queued tasks until every task of the group has finished, then rethrows the first task exception
+    void wait(TaskGroup &group);
+
+private:
+    struct Task {
+        std::function<void()> function;
+        TaskGroup *group = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(unsigned queueIndex);
+    bool tryPop(unsigned queueIndex, Task &task);
+    void execute(Task &task);
+    unsigned currentQueueIndex() const;
+
+    // queue 0 belongs to external threads (the ones calling submit/wait from outside the pool),
+    // queue i + 1 belongs to workers[i]
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    std::atomic<size_t> queuedTasks{0};
+    bool stopping = false;
+};
+
+} // namespace lve
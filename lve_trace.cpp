@@ -0,0 +1,193 @@
+#include "lve_trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace lve {
+
+namespace {
+
+struct Event {
+    const char *name;
+    int index;
+    uint64_t begin;
+    uint64_t end;
+};
+
+struct EventBuffer {
+    uint32_t id;
+    std::string name;
+    std::unique_ptr<Event[]> events{new Event[LveTrace::EVENTS_PER_THREAD]};
+    // events pushed so far, only the owning thread stores it
+    std::atomic<size_t> count{0};
+    // events already in a file, only writeChromeTrace stores it; slots below it can be reused
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> dropped{0};
+
+    void push(const Event &event) {
+        size_t index = count.load(std::memory_order_relaxed);
+        // acquire so writeChromeTrace is done reading the slot before it is overwritten
+        if (index - written.load(std::memory_order_acquire) >= LveTrace::EVENTS_PER_THREAD) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[index % LveTrace::EVENTS_PER_THREAD] = event;
+        // publishes the event to writeChromeTrace
+        count.store(index + 1, std::memory_order_release);
+    }
+};
+
+std::atomic<bool> enabled{false};
+std::atomic<int64_t> originNs{0};
+
+// buffers are only ever added, never removed, so a thread's buffer stays valid after the thread exits
+std::mutex registryMutex;
+std::vector<std::unique_ptr<EventBuffer>> buffers;
+thread_local EventBuffer *threadBuffer = nullptr;
+EventBuffer *gpuBuffer = nullptr;
+
+int64_t steadyNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// registryMutex has to be held
+EventBuffer *registerBuffer() {
+    buffers.push_back(std::make_unique<EventBuffer>());
+    buffers.back()->id = static_cast<uint32_t>(buffers.size());
+    buffers.back()->name = "thread " + std::to_string(buffers.size());
+    return buffers.back().get();
+}
+
+EventBuffer &currentThreadBuffer() {
+    if (threadBuffer == nullptr) {
+        std::lock_guard<std::mutex> lock{registryMutex};
+        threadBuffer = registerBuffer();
+    }
+    return *threadBuffer;
+}
+
+void writeName(std::ofstream &out, const Event &event) {
+    out << '"';
+    for (const char *c = event.name; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    if (event.index >= 0) {
+        out << ' ' << event.index;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void LveTrace::start() {
+    originNs.store(steadyNow(), std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock{registryMutex};
+    if (gpuBuffer == nullptr) {
+        gpuBuffer = registerBuffer();
+        gpuBuffer->name = "gpu";
+    }
+    enabled.store(true, std::memory_order_release);
+}
+
+void LveTrace::stop() {
+    enabled.store(false, std::memory_order_release);
+}
+
+bool LveTrace::isEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+uint64_t LveTrace::now() {
+    return toTraceTime(static_cast<uint64_t>(steadyNow()));
+}
+
+uint64_t LveTrace::toTraceTime(uint64_t steadyClockNs) {
+    int64_t time = static_cast<int64_t>(steadyClockNs) - originNs.load(std::memory_order_relaxed);
+    return time > 0 ? static_cast<uint64_t>(time) : 0;
+}
+
+void LveTrace::addEvent(const char *name, int index, uint64_t beginNs, uint64_t endNs) {
+    if (!isEnabled()) {
+        return;
+    }
+    currentThreadBuffer().push({name, index, beginNs, endNs});
+}
+
+void LveTrace::addGpuEvent(const char *name, int index, uint64_t beginNs, uint64_t endNs) {
+    if (!isEnabled()) {
+        return;
+    }
+    gpuBuffer->push({name, index, beginNs, endNs});
+}
+
+void LveTrace::setThreadName(const char *name) {
+    std::lock_guard<std::mutex> lock{registryMutex};
+    if (threadBuffer == nullptr) {
+        threadBuffer = registerBuffer();
+    }
+    threadBuffer->name = name;
+}
+
+void LveTrace::writeChromeTrace(const std::string &path) {
+    std::ofstream out{path};
+    if (!out) {
+        throw std::runtime_error("failed to open trace file: " + path);
+    }
+
+    std::lock_guard<std::mutex> lock{registryMutex};
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for (auto &buffer : buffers) {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id
+            << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+
+        // only events below the published count are complete
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        size_t begin = buffer->written.load(std::memory_order_relaxed);
+        for (size_t i = begin; i < count; i++) {
+            const Event &event = buffer->events[i % EVENTS_PER_THREAD];
+            // complete events, times in microseconds
+            out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"name\":";
+            writeName(out, event);
+            out << ",\"ts\":" << event.begin / 1000 << '.' << event.begin % 1000 / 100
+                << ",\"dur\":" << (event.end - event.begin) / 1000 << '.' << (event.end - event.begin) % 1000 / 100
+                << '}';
+        }
+        // hands the slots back to the owning thread, the next file starts after these events
+        buffer->written.store(count, std::memory_order_release);
+        size_t dropped = buffer->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            out << ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" << buffer->id << ",\"name\":\"" << dropped
+                << " events dropped, buffer full\",\"ts\":0}";
+        }
+    }
+    out << "\n]}\n";
+}
+
+LveTraceZone::LveTraceZone(const char *name, int index) : name{name}, index{index}, enabled{LveTrace::isEnabled()} {
+    if (enabled) {
+        begin = LveTrace::now();
+    }
+}
+
+LveTraceZone::~LveTraceZone() {
+    if (enabled) {
+        LveTrace::addEvent(name, index, begin, LveTrace::now());
+    }
+}
+
+} // namespace lve
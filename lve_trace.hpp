@@ -0,0 +1,54 @@
+#pragma once
+
+// std lib headers
+#include <cstdint>
+#include <string>
+
+namespace lve {
+
+// CPU (and GPU) timeline in the Chrome trace event format, open the file in chrome://tracing or
+// https://ui.perfetto.dev.
+// Every thread records into its own fixed size ring: only the owning thread writes, it publishes
+// the new event count with a release store and the writer of the file reads it with an acquire
+// load, so recording never takes a lock. Writing a file hands the space of its events back, a ring
+// that runs full drops events until the next write instead of growing.
+// Everything is a no-op until start() is called.
+class LveTrace {
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+    static void start();
+    static void stop();
+    static bool isEnabled();
+
+    // nanoseconds on the trace clock (steady_clock, 0 at start())
+    static uint64_t now();
+    static uint64_t toTraceTime(uint64_t steadyClockNs);
+
+    // names must outlive the trace (string literals), index < 0 leaves it out of the name
+    static void addEvent(const char *name, int index, uint64_t beginNs, uint64_t endNs);
+    // events on the "gpu" track, times already converted to the trace clock; one thread only
+    static void addGpuEvent(const char *name, int index, uint64_t beginNs, uint64_t endNs);
+    // shown instead of the thread id in the viewer
+    static void setThreadName(const char *name);
+
+    // writes everything recorded since the previous call, can be called at any time
+    static void writeChromeTrace(const std::string &path);
+};
+
+// Records the time between its construction and destruction on the current thread.
+class LveTraceZone {
+public:
+    explicit LveTraceZone(const char *name, int index = -1);
+    ~LveTraceZone();
+    LveTraceZone(const LveTraceZone &) = delete;
+    LveTraceZone &operator=(const LveTraceZone &) = delete;
+
+private:
+    const char *name;
+    int index;
+    uint64_t begin = 0;
+    bool enabled;
+};
+
+} // namespace lve
@@ -0,0 +1,131 @@
+#include "lve_uploader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace lve {
+
+LveUploader::LveUploader(LveDevice &device, VkDeviceSize stagingSize) : lveDevice{device}, capacity{stagingSize} {
+    lveDevice.createBuffer(
+        capacity,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        stagingBuffer,
+        stagingBufferMemory);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = lveDevice.getCommandPool();
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(lveDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate upload command buffer");
+    }
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(lveDevice.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upload fence");
+    }
+}
+
+LveUploader::~LveUploader() {
+    // callers flush themselves, this only catches a forgotten one. A destructor mustn't throw,
+    // a failed submit just leaves the destination buffers empty
+    try {
+        flush();
+    } catch (const std::exception &e) {
+        std::cerr << "uploader: pending uploads lost: " << e.what() << std::endl;
+    }
+    vkDestroyFence(lveDevice.device(), fence, nullptr);
+    vkFreeCommandBuffers(lveDevice.device(), lveDevice.getCommandPool(), 1, &commandBuffer);
+    vkDestroyBuffer(lveDevice.device(), stagingBuffer, nullptr);
+    lveDevice.allocator().free(stagingBufferMemory);
+}
+
+void LveUploader::beginBatch() {
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin upload command buffer");
+    }
+    recording = true;
+    head = 0;
+}
+
+void LveUploader::upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size) {
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        if (!recording) {
+            beginBatch();
+        }
+        // keep every copy 16 byte aligned inside the staging buffer
+        head = (head + 15) & ~VkDeviceSize{15};
+        if (head >= capacity) {
+            flush();
+            continue;
+        }
+
+        VkDeviceSize chunk = std::min(size, capacity - head);
+        memcpy(static_cast<char *>(stagingBufferMemory.mapped) + head, bytes, static_cast<size_t>(chunk));
+
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = head;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = chunk;
+        vkCmdCopyBuffer(commandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+
+        head += chunk;
+        bytes += chunk;
+        dstOffset += chunk;
+        size -= chunk;
+        if (size > 0) {
+            // the ring is full, the rest goes into the next batch
+            flush();
+        }
+    }
+}
+
+void LveUploader::flush() {
+    if (!recording) {
+        return;
+    }
+
+    // make the copies visible to every way the destination buffers are read later on
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record upload command buffer");
+    }
+    recording = false;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    if (vkQueueSubmit(lveDevice.graphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit upload command buffer");
+    }
+    submissions++;
+
+    // waiting on our own fence instead of vkQueueWaitIdle leaves other work on the queue alone
+    vkWaitForFences(lveDevice.device(), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    vkResetFences(lveDevice.device(), 1, &fence);
+    head = 0;
+}
+
+} // namespace lve
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "lve_device.hpp"
+
+namespace lve {
+
+// Uploads data into DEVICE_LOCAL buffers through one persistently mapped staging buffer.
+// upload() copies the bytes into the staging ring and records a vkCmdCopyBuffer, flush()
+// submits everything recorded so far in a single submission and waits for it, after which
+// the ring is reused from the start. When the ring runs full in the middle of a batch it is
+// flushed early, so uploads of any size work, they just take more than one submission.
+// Destination buffers must not be used by the gpu before the flush that uploads them.
+// Callers flush() themselves, the destructor only submits leftovers as a last resort and logs
+// instead of throwing when that fails.
+class LveUploader {
+public:
+    static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 64 * 1024 * 1024;
+
+    LveUploader(LveDevice &device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+    ~LveUploader();
+    LveUploader(const LveUploader &) = delete;
+    LveUploader &operator=(const LveUploader &) = delete;
+
+    void upload(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size);
+    void flush();
+
+    // number of submissions so far, handy to check that batching works
+    uint32_t submissionCount() const { return submissions; }
+
+private:
+    void beginBatch();
+
+    LveDevice &lveDevice;
+    VkBuffer stagingBuffer;
+    // host visible, so the allocator keeps it mapped for us
+    LveAllocation stagingBufferMemory;
+    VkDeviceSize capacity;
+    VkDeviceSize head = 0;
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence;
+    bool recording = false;
+    uint32_t submissions = 0;
+};
+
+} // namespace lve
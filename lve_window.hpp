@@ -11,6 +11,7 @@ namespace lve {
         LveWindow& operator=(const LveWindow&) = delete;
         ~LveWindow();
         bool shouldClose() { return glfwWindowShouldClose(window); }
+        bool isKeyPressed(int key) { return glfwGetKey(window, key) == GLFW_PRESS; }
         bool wasWindowResized() {return framebufferResized;}
         void resetWindowResizeFlag(){framebufferResized = false;}
         VkExtent2D getExtend(){
@@ -4,15 +4,86 @@
 #include <stdexcept>
 #include <iostream>
 #include <cstdlib>
+#include <string>
+
+int main(int argc, char **argv){
+    lve::FirstAppConfig config{};
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--gpu-generation") {
+            config.gpuGeneration = true;
+        } else if (arg == "--validate-gpu-generation") {
+            config.gpuGeneration = true;
+            config.validateGpuGeneration = true;
+        } else if (arg == "--render-mode=vertices") {
+            config.renderMode = lve::RenderMode::Vertices;
+        } else if (arg == "--render-mode=instanced") {
+            config.renderMode = lve::RenderMode::Instanced;
+        } else if (arg == "--render-mode=procedural") {
+            config.renderMode = lve::RenderMode::Procedural;
+        } else if (arg == "--indexed") {
+            config.indexed = true;
+        } else if (arg == "--vertex-format=float") {
+            config.vertexFormat = lve::VertexFormat::Float;
+        } else if (arg == "--vertex-format=packed16") {
+            config.vertexFormat = lve::VertexFormat::Packed16;
+        } else if (arg == "--vertex-format=packed32") {
+            config.vertexFormat = lve::VertexFormat::Packed32;
+        } else if (arg.rfind("--max-depth=", 0) == 0) {
+            config.maxDepth = std::stoi(arg.substr(std::string("--max-depth=").size()));
+            if (config.maxDepth < 1) {
+                std::cerr << "--max-depth needs at least 1 level: " << arg << '\n';
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--headless") {
+            config.headless = true;
+        } else if (arg.rfind("--headless=", 0) == 0) {
+            config.headless = true;
+            config.headlessFrames = std::stoi(arg.substr(std::string("--headless=").size()));
+        } else if (arg.rfind("--record=", 0) == 0) {
+            config.headless = true;
+            config.recordPath = arg.substr(std::string("--record=").size());
+        } else if (arg == "--indirect") {
+            config.indirect = true;
+        } else if (arg == "--gpu-culling") {
+            config.gpuCulling = true;
+        } else if (arg.rfind("--gpu-culling=", 0) == 0) {
+            config.gpuCulling = true;
+            config.cullThreshold = std::stof(arg.substr(std::string("--gpu-culling=").size()));
+        } else if (arg == "--parallel-recording") {
+            config.parallelRecording = true;
+        } else if (arg.rfind("--parallel-recording=", 0) == 0) {
+            config.parallelRecording = true;
+            int chunks = std::stoi(arg.substr(std::string("--parallel-recording=").size()));
+            if (chunks < 1) {
+                std::cerr << "--parallel-recording needs at least 1 command buffer: " << arg << '\n';
+                return EXIT_FAILURE;
+            }
+            config.recordingChunks = static_cast<unsigned>(chunks);
+        } else if (arg.rfind("--trace=", 0) == 0) {
+            config.tracePath = arg.substr(std::string("--trace=").size());
+        } else if (arg.rfind("--frames-in-flight=", 0) == 0) {
+            config.framesInFlight = std::stoi(arg.substr(std::string("--frames-in-flight=").size()));
+        } else {
+            std::cerr << "unknown option: " << arg << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (config.recordPath == "-") {
+        // stdout carries the frames, everything the app prints goes to stderr instead
+        std::cout.rdbuf(std::cerr.rdbuf());
+    }
 
-int main(){
-    lve::FirstApp app{};
     try {
+        // constructed inside the try block so startup failures (like a failed gpu validation) are reported too
+        lve::FirstApp app{config};
         app.run();
         std::cout<<"Hello Vulkan!"<<std::endl;
     } catch (const std::exception& e) {
         std::cerr << e.what() << '\n';
         std::cout<<"Hello Vulkan!2"<<std::endl;
+        return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
 }
\ No newline at end of file
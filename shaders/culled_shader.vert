@@ -0,0 +1,22 @@
+#version 450
+
+// One instance per sub-triangle that survived sierpinski_cull.comp: the root triangle scaled and moved
+// to where the sub-triangle is. Tiny ones stand for everything below them.
+layout (location = 0) in vec4 instance;
+
+layout (push_constant) uniform Push {
+    mat2 transform;
+    vec2 offset;
+    vec4 color;
+} push;
+
+layout (location = 0) flat out vec4 fragColor;
+
+// root triangle corners in SierpinskiGenerator order: top, right, left
+const vec2 CORNERS[3] = vec2[](vec2(0.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main(){
+    vec2 position = instance.z * CORNERS[gl_VertexIndex] + instance.xy;
+    gl_Position = vec4(push.transform * position + push.offset, 0.0, 1.0);
+    fragColor = push.color;
+}
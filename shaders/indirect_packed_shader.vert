@@ -0,0 +1,33 @@
+#version 450
+
+// LveModel::PackedVertex16 / PackedVertex32, see packed_shader.vert
+layout (location = 0) in ivec2 position;
+
+layout (constant_id = 0) const float POSITION_SCALE = 1.0 / 16384.0;
+
+// IndirectObjectData, one per game object
+struct ObjectData {
+    vec4 transform;
+    vec4 color;
+    vec2 offset;
+    int level;
+    int padding;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// only non zero when the device can't use firstInstance
+layout (push_constant) uniform Push {
+    uint firstObject;
+} push;
+
+layout (location = 0) flat out vec4 fragColor;
+
+void main(){
+    ObjectData object = objects[gl_InstanceIndex + push.firstObject];
+    mat2 transform = mat2(object.transform.xy, object.transform.zw);
+    gl_Position = vec4(transform * (vec2(position) * POSITION_SCALE) + object.offset, 0.0, 1.0);
+    fragColor = object.color;
+}
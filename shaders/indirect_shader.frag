@@ -0,0 +1,13 @@
+#version 450
+
+layout (location = 0) flat in vec4 fragColor;
+
+layout (location = 0) out vec4 outColor;
+
+// false for the opaque variant: the alpha is ignored and the pipeline has blending turned off
+layout (constant_id = 0) const bool BLENDED = true;
+
+void main()
+{
+    outColor = vec4(fragColor.rgb, BLENDED ? fragColor.a : 1.0);
+}
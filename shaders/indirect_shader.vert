@@ -0,0 +1,31 @@
+#version 450
+
+// LveModel::Vertex, the color isn't read
+layout (location = 0) in vec2 position;
+
+// IndirectObjectData, one per game object
+struct ObjectData {
+    vec4 transform;
+    vec4 color;
+    vec2 offset;
+    int level;
+    int padding;
+};
+
+layout (std430, set = 0, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+// only non zero when the device can't use firstInstance
+layout (push_constant) uniform Push {
+    uint firstObject;
+} push;
+
+layout (location = 0) flat out vec4 fragColor;
+
+void main(){
+    ObjectData object = objects[gl_InstanceIndex + push.firstObject];
+    mat2 transform = mat2(object.transform.xy, object.transform.zw);
+    gl_Position = vec4(transform * position + object.offset, 0.0, 1.0);
+    fragColor = object.color;
+}
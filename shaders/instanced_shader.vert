@@ -0,0 +1,17 @@
+#version 450
+
+// one reference triangle (already scaled to its level) drawn once per sub-triangle
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec3 color;
+layout (location = 2) in vec2 instanceOffset;
+
+layout (push_constant) uniform Push {
+    mat2 transform;
+    vec2 offset;
+    vec3 color;
+    float alpha; 
+} push;
+
+void main(){
+    gl_Position = vec4(push.transform * (position + instanceOffset) + push.offset, 0.0, 1.0);
+}
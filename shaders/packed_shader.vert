@@ -0,0 +1,18 @@
+#version 450
+
+// LveModel::PackedVertex16 / PackedVertex32: fixed point positions, no color
+layout (location = 0) in ivec2 position;
+
+// 2^-FRACTION_BITS of the vertex format, a power of two keeps the positions exact
+layout (constant_id = 0) const float POSITION_SCALE = 1.0 / 16384.0;
+
+layout (push_constant) uniform Push {
+    mat2 transform;
+    vec2 offset;
+    vec3 color;
+    float alpha; 
+} push;
+
+void main(){
+    gl_Position = vec4(push.transform * (vec2(position) * POSITION_SCALE) + push.offset, 0.0, 1.0);
+}
@@ -0,0 +1,40 @@
+#version 450
+
+// No vertex buffer at all: the position is decoded from gl_VertexIndex.
+// Triangle t = gl_VertexIndex / 3 of level push.level is read as base-3 digits, every digit picks
+// the corner sub-triangle taken on the way down from the root, the same numbering as
+// SierpinskiLevel::offset. Works up to level 19, where 3 * 3^19 still fits in 32 bits.
+
+layout (push_constant) uniform Push {
+    mat2 transform;
+    vec2 offset;
+    vec3 color;
+    float alpha;
+    int level;
+} push;
+
+// highest level drawn with this pipeline, a constant loop bound lets the compiler unroll the digit loop
+layout (constant_id = 0) const int MAX_LEVEL = 19;
+
+// root triangle corners in SierpinskiGenerator order: top, right, left
+const vec2 CORNERS[3] = vec2[](vec2(0.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main(){
+    uint vertex = uint(gl_VertexIndex);
+    uint triangle = vertex / 3u;
+
+    // least significant digit first, it is the smallest step; ldexp keeps every term exact
+    vec2 position = vec2(0.0);
+    float scale = ldexp(1.0, -push.level);
+    for (int j = 0; j < MAX_LEVEL; j++) {
+        if (j >= push.level) {
+            break;
+        }
+        position += scale * CORNERS[triangle % 3u];
+        triangle /= 3u;
+        scale *= 2.0;
+    }
+    position += ldexp(1.0, -push.level) * CORNERS[vertex % 3u];
+
+    gl_Position = vec4(push.transform * position + push.offset, 0.0, 1.0);
+}
@@ -2,6 +2,9 @@
 
 layout(location = 0) out vec4 outColor;
 
+// false for the opaque variant: push.alpha is ignored and the pipeline has blending turned off
+layout (constant_id = 0) const bool BLENDED = true;
+
 layout (push_constant) uniform Push {
     mat2 transform;
     vec2 offset;
@@ -11,5 +14,5 @@ layout (push_constant) uniform Push {
 
 void main()
 {
-    outColor = vec4(push.color, push.alpha);
+    outColor = vec4(push.color, BLENDED ? push.alpha : 1.0);
 }
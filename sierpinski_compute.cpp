@@ -0,0 +1,256 @@
+#include "sierpinski_compute.hpp"
+#include "sierpinski_generator.hpp"
+#include "sierpinski_level.hpp"
+#include "shaders/sierpinski_expand.comp.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+namespace {
+struct ExpandPushConstantData {
+    uint32_t firstParent;
+    uint32_t parentCount;
+};
+
+// matches local_size_x in sierpinski_expand.comp
+constexpr uint32_t WORKGROUP_SIZE = 64;
+} // namespace
+
+SierpinskiComputeGenerator::SierpinskiComputeGenerator(LveDevice &device) : lveDevice{device} {
+    createDescriptorSetLayout();
+    createPipelineLayout();
+    createPipeline();
+}
+
+SierpinskiComputeGenerator::~SierpinskiComputeGenerator() {
+    lveComputePipeline = nullptr;
+    vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(lveDevice.device(), descriptorSetLayout, nullptr);
+}
+
+void SierpinskiComputeGenerator::createDescriptorSetLayout() {
+    // binding 0 is the parent level, binding 1 the child level
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+
+    if (vkCreateDescriptorSetLayout(lveDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout");
+    }
+}
+
+void SierpinskiComputeGenerator::createPipelineLayout() {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(ExpandPushConstantData);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(lveDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout");
+    }
+}
+
+void SierpinskiComputeGenerator::createPipeline() {
+    lveComputePipeline = std::make_unique<LveComputePipeline>(
+        lveDevice,
+        shaders::sierpinski_expand_comp,
+        pipelineLayout);
+}
+
+std::vector<std::shared_ptr<LveModel>> SierpinskiComputeGenerator::generate(int levelCount, bool validate) {
+    if (levelCount < 1) {
+        throw std::runtime_error("gpu generation needs at least one level");
+    }
+
+    // checked before anything is allocated
+    for (int level = 1; level < levelCount; level++) {
+        VkDeviceSize size = sizeof(LveModel::Vertex) * 3 * SierpinskiGenerator::triangleCount(level);
+        if (size > lveDevice.properties.limits.maxStorageBufferRange) {
+            throw std::runtime_error("level " + std::to_string(level) + " is larger than maxStorageBufferRange");
+        }
+    }
+
+    // every buffer belongs to its model as soon as it exists, so a throw further down frees them
+    std::vector<LevelBuffer> levels(levelCount);
+    std::vector<std::shared_ptr<LveModel>> models;
+    for (int level = 0; level < levelCount; level++) {
+        levels[level].vertexCount = static_cast<uint32_t>(3 * SierpinskiGenerator::triangleCount(level));
+        VkDeviceSize size = sizeof(LveModel::Vertex) * levels[level].vertexCount;
+        // storage buffer for the compute shader, vertex buffer for drawing,
+        // transfer dst for the root triangle and transfer src for validation
+        lveDevice.createBuffer(
+            size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            levels[level].buffer,
+            levels[level].memory);
+        models.push_back(std::make_shared<LveModel>(
+            lveDevice, levels[level].buffer, levels[level].memory, levels[level].vertexCount));
+    }
+
+    // one descriptor set per expansion step: (level k, level k + 1)
+    uint32_t stepCount = static_cast<uint32_t>(levelCount - 1);
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::vector<VkDescriptorSet> descriptorSets(stepCount);
+    if (stepCount > 0) {
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 2 * stepCount;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = stepCount;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        if (vkCreateDescriptorPool(lveDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool");
+        }
+
+        std::vector<VkDescriptorSetLayout> setLayouts(stepCount, descriptorSetLayout);
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = stepCount;
+        allocInfo.pSetLayouts = setLayouts.data();
+        if (vkAllocateDescriptorSets(lveDevice.device(), &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+            vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+            throw std::runtime_error("failed to allocate descriptor sets");
+        }
+
+        for (uint32_t step = 0; step < stepCount; step++) {
+            std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+            bufferInfos[0] = {levels[step].buffer, 0, VK_WHOLE_SIZE};
+            bufferInfos[1] = {levels[step + 1].buffer, 0, VK_WHOLE_SIZE};
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = descriptorSets[step];
+            write.dstBinding = 0;
+            write.descriptorCount = static_cast<uint32_t>(bufferInfos.size());
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            write.pBufferInfo = bufferInfos.data();
+            vkUpdateDescriptorSets(lveDevice.device(), 1, &write, 0, nullptr);
+        }
+    }
+
+    VkCommandBuffer commandBuffer = lveDevice.beginSingleTimeCommands();
+
+    // the root triangle is small enough to go inside the command buffer itself, no staging needed
+    auto root = SierpinskiGenerator::rootTriangle();
+    std::array<LveModel::Vertex, 3> rootVertices{};
+    rootVertices[0].position = root.top;
+    rootVertices[1].position = root.right;
+    rootVertices[2].position = root.left;
+    vkCmdUpdateBuffer(commandBuffer, levels[0].buffer, 0, sizeof(rootVertices), rootVertices.data());
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    lveComputePipeline->bind(commandBuffer);
+    uint32_t maxInvocations = static_cast<uint32_t>(std::min<uint64_t>(
+        static_cast<uint64_t>(lveDevice.properties.limits.maxComputeWorkGroupCount[0]) * WORKGROUP_SIZE, 1u << 30));
+    for (uint32_t step = 0; step < stepCount; step++) {
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_COMPUTE,
+            pipelineLayout,
+            0, 1, &descriptorSets[step],
+            0, nullptr);
+
+        // deep levels can need more workgroups than one dispatch allows, so they are split
+        uint32_t parentCount = levels[step].vertexCount / 3;
+        for (uint32_t first = 0; first < parentCount; first += maxInvocations) {
+            ExpandPushConstantData push{first, parentCount};
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+            uint32_t invocations = std::min(parentCount - first, maxInvocations);
+            vkCmdDispatch(commandBuffer, (invocations + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+        }
+
+        // the next step reads what this one wrote, drawing and validation read it later
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    lveDevice.endSingleTimeCommands(commandBuffer);
+
+    if (descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(lveDevice.device(), descriptorPool, nullptr);
+    }
+
+    if (validate) {
+        validateLevels(levels);
+    }
+
+    return models;
+}
+
+void SierpinskiComputeGenerator::validateLevels(const std::vector<LevelBuffer> &levels) {
+    for (size_t level = 0; level < levels.size(); level++) {
+        uint32_t vertexCount = levels[level].vertexCount;
+        VkDeviceSize size = sizeof(LveModel::Vertex) * vertexCount;
+
+        // allocated first, nothing between creating and destroying the staging buffer can throw
+        std::vector<LveModel::Vertex> gpuVertices(vertexCount);
+        VkBuffer stagingBuffer;
+        LveAllocation stagingBufferMemory;
+        lveDevice.createBuffer(
+            size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory);
+        lveDevice.copyBuffer(levels[level].buffer, stagingBuffer, size);
+        memcpy(gpuVertices.data(), stagingBufferMemory.mapped, static_cast<size_t>(size));
+        vkDestroyBuffer(lveDevice.device(), stagingBuffer, nullptr);
+        lveDevice.allocator().free(stagingBufferMemory);
+
+        std::vector<LveModel::Vertex> cpuVertices(vertexCount);
+        SierpinskiLevel::generateRange(static_cast<int>(level), 0, vertexCount / 3, cpuVertices.data());
+
+        // all coordinates are dyadic fractions, the gpu has to match the cpu bit for bit
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            if (gpuVertices[i].position != cpuVertices[i].position) {
+                throw std::runtime_error(
+                    "gpu generated level " + std::to_string(level) + " differs from the cpu at vertex " + std::to_string(i));
+            }
+        }
+    }
+    std::cout << "gpu generation validated: " << levels.size() << " levels match the cpu generator" << std::endl;
+}
+
+} // namespace lve
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "lve_compute_pipeline.hpp"
+#include "lve_device.hpp"
+#include "lve_model.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace lve {
+
+// Generates the Sierpinski levels on the gpu.
+// Level 0 is written with vkCmdUpdateBuffer, then every level k + 1 is expanded from level k by
+// shaders/sierpinski_expand.comp straight into device local buffers that are also used as the
+// vertex buffers of the returned models. Everything is recorded into one command buffer, so the
+// cpu only records a few commands and no vertex data crosses the bus.
+class SierpinskiComputeGenerator {
+public:
+    explicit SierpinskiComputeGenerator(LveDevice &device);
+    ~SierpinskiComputeGenerator();
+    SierpinskiComputeGenerator(const SierpinskiComputeGenerator &) = delete;
+    SierpinskiComputeGenerator &operator=(const SierpinskiComputeGenerator &) = delete;
+
+    // levels 0 .. levelCount - 1 in the order of SierpinskiGenerator::generate.
+    // With validate set every level is read back and compared with the cpu generator,
+    // a mismatch throws.
+    std::vector<std::shared_ptr<LveModel>> generate(int levelCount, bool validate = false);
+
+private:
+    struct LevelBuffer {
+        VkBuffer buffer;
+        LveAllocation memory;
+        uint32_t vertexCount;
+    };
+
+    void createDescriptorSetLayout();
+    void createPipelineLayout();
+    void createPipeline();
+    void validateLevels(const std::vector<LevelBuffer> &levels);
+
+    LveDevice &lveDevice;
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkPipelineLayout pipelineLayout;
+    std::unique_ptr<LveComputePipeline> lveComputePipeline;
+};
+
+} // namespace lve
@@ -0,0 +1,245 @@
+#include "sierpinski_expand.hpp"
+
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LVE_EXPAND_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define LVE_EXPAND_NEON 1
+#include <arm_neon.h>
+#endif
+
+// AVX2 code is compiled with a per-function target attribute so the rest of the binary
+// still runs on CPUs without it, that needs GCC or Clang
+#if defined(LVE_EXPAND_X86) && defined(__GNUC__)
+#define LVE_EXPAND_AVX2 1
+#endif
+
+namespace lve {
+
+void SierpinskiSoA::resize(size_t count) {
+    topX.resize(count);
+    topY.resize(count);
+    rightX.resize(count);
+    rightY.resize(count);
+    leftX.resize(count);
+    leftY.resize(count);
+}
+
+namespace {
+
+// Every kernel loads the 6 parent coordinates and computes the 6 midpoint coordinates:
+//   values = {topX, topY, rightX, rightY, leftX, leftY,
+//             topRightX, topRightY, rightLeftX, rightLeftY, topLeftX, topLeftY}
+// and then writes 18 child streams (child-major, then corner top/right/left, then x/y)
+// picking from that table.
+constexpr int CHILD_PICK[18] = {
+    0, 1, 6, 7, 10, 11,  // child 0: top, topRight, topLeft
+    6, 7, 2, 3, 8, 9,    // child 1: topRight, right, rightLeft
+    10, 11, 8, 9, 4, 5}; // child 2: topLeft, rightLeft, left
+
+struct Streams {
+    const float *in[6];
+    float *out[18];
+};
+
+Streams makeStreams(const SierpinskiSoA &parents, SierpinskiSoA &children) {
+    assert(children.size() == 3 * parents.size() && "children must hold three triangles per parent");
+    size_t n = parents.size();
+    Streams streams{
+        {parents.topX.data(), parents.topY.data(), parents.rightX.data(),
+         parents.rightY.data(), parents.leftX.data(), parents.leftY.data()},
+        {}};
+    float *planes[6] = {children.topX.data(), children.topY.data(), children.rightX.data(),
+                        children.rightY.data(), children.leftX.data(), children.leftY.data()};
+    for (int child = 0; child < 3; child++) {
+        for (int coordinate = 0; coordinate < 6; coordinate++) {
+            streams.out[child * 6 + coordinate] = planes[coordinate] + child * n;
+        }
+    }
+    return streams;
+}
+
+void expandScalarRange(const Streams &s, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        float v[12];
+        for (int k = 0; k < 6; k++) {
+            v[k] = s.in[k][i];
+        }
+        v[6] = (v[0] + v[2]) * 0.5f;
+        v[7] = (v[1] + v[3]) * 0.5f;
+        v[8] = (v[2] + v[4]) * 0.5f;
+        v[9] = (v[3] + v[5]) * 0.5f;
+        v[10] = (v[0] + v[4]) * 0.5f;
+        v[11] = (v[1] + v[5]) * 0.5f;
+        for (int k = 0; k < 18; k++) {
+            s.out[k][i] = v[CHILD_PICK[k]];
+        }
+    }
+}
+
+void expandScalar(const SierpinskiSoA &parents, SierpinskiSoA &children, size_t begin, size_t end) {
+    expandScalarRange(makeStreams(parents, children), begin, end);
+}
+
+#ifdef LVE_EXPAND_X86
+void expandSSE(const SierpinskiSoA &parents, SierpinskiSoA &children, size_t begin, size_t end) {
+    Streams s = makeStreams(parents, children);
+    const __m128 half = _mm_set1_ps(0.5f);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 v[12];
+        for (int k = 0; k < 6; k++) {
+            v[k] = _mm_loadu_ps(s.in[k] + i);
+        }
+        v[6] = _mm_mul_ps(_mm_add_ps(v[0], v[2]), half);
+        v[7] = _mm_mul_ps(_mm_add_ps(v[1], v[3]), half);
+        v[8] = _mm_mul_ps(_mm_add_ps(v[2], v[4]), half);
+        v[9] = _mm_mul_ps(_mm_add_ps(v[3], v[5]), half);
+        v[10] = _mm_mul_ps(_mm_add_ps(v[0], v[4]), half);
+        v[11] = _mm_mul_ps(_mm_add_ps(v[1], v[5]), half);
+        for (int k = 0; k < 18; k++) {
+            _mm_storeu_ps(s.out[k] + i, v[CHILD_PICK[k]]);
+        }
+    }
+    expandScalarRange(s, i, end);
+}
+#endif
+
+#ifdef LVE_EXPAND_AVX2
+__attribute__((target("avx2"))) void expandAVX2(
+    const SierpinskiSoA &parents, SierpinskiSoA &children, size_t begin, size_t end) {
+    Streams s = makeStreams(parents, children);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 v[12];
+        for (int k = 0; k < 6; k++) {
+            v[k] = _mm256_loadu_ps(s.in[k] + i);
+        }
+        v[6] = _mm256_mul_ps(_mm256_add_ps(v[0], v[2]), half);
+        v[7] = _mm256_mul_ps(_mm256_add_ps(v[1], v[3]), half);
+        v[8] = _mm256_mul_ps(_mm256_add_ps(v[2], v[4]), half);
+        v[9] = _mm256_mul_ps(_mm256_add_ps(v[3], v[5]), half);
+        v[10] = _mm256_mul_ps(_mm256_add_ps(v[0], v[4]), half);
+        v[11] = _mm256_mul_ps(_mm256_add_ps(v[1], v[5]), half);
+        for (int k = 0; k < 18; k++) {
+            _mm256_storeu_ps(s.out[k] + i, v[CHILD_PICK[k]]);
+        }
+    }
+    expandScalarRange(s, i, end);
+}
+#endif
+
+#ifdef LVE_EXPAND_NEON
+void expandNEON(const SierpinskiSoA &parents, SierpinskiSoA &children, size_t begin, size_t end) {
+    Streams s = makeStreams(parents, children);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        float32x4_t v[12];
+        for (int k = 0; k < 6; k++) {
+            v[k] = vld1q_f32(s.in[k] + i);
+        }
+        v[6] = vmulq_f32(vaddq_f32(v[0], v[2]), half);
+        v[7] = vmulq_f32(vaddq_f32(v[1], v[3]), half);
+        v[8] = vmulq_f32(vaddq_f32(v[2], v[4]), half);
+        v[9] = vmulq_f32(vaddq_f32(v[3], v[5]), half);
+        v[10] = vmulq_f32(vaddq_f32(v[0], v[4]), half);
+        v[11] = vmulq_f32(vaddq_f32(v[1], v[5]), half);
+        for (int k = 0; k < 18; k++) {
+            vst1q_f32(s.out[k] + i, v[CHILD_PICK[k]]);
+        }
+    }
+    expandScalarRange(s, i, end);
+}
+#endif
+
+} // namespace
+
+bool SierpinskiExpander::isSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Best:
+        case Kernel::Scalar:
+            return true;
+        case Kernel::SSE:
+#ifdef LVE_EXPAND_X86
+            return true;
+#else
+            return false;
+#endif
+        case Kernel::AVX2:
+#ifdef LVE_EXPAND_AVX2
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        case Kernel::NEON:
+#ifdef LVE_EXPAND_NEON
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char *SierpinskiExpander::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Best: return "best";
+        case Kernel::Scalar: return "scalar";
+        case Kernel::SSE: return "sse";
+        case Kernel::AVX2: return "avx2";
+        case Kernel::NEON: return "neon";
+    }
+    return "unknown";
+}
+
+SierpinskiExpander::SierpinskiExpander(Kernel kernel) {
+    if (kernel == Kernel::Best) {
+        kernel = Kernel::Scalar;
+        for (auto candidate : {Kernel::NEON, Kernel::SSE, Kernel::AVX2}) {
+            if (isSupported(candidate)) {
+                kernel = candidate;
+            }
+        }
+    }
+    if (!isSupported(kernel)) {
+        throw std::runtime_error(std::string("expansion kernel not supported on this CPU: ") + kernelName(kernel));
+    }
+
+    selectedKernel = kernel;
+    switch (kernel) {
+#ifdef LVE_EXPAND_X86
+        case Kernel::SSE: function = expandSSE; break;
+#endif
+#ifdef LVE_EXPAND_AVX2
+        case Kernel::AVX2: function = expandAVX2; break;
+#endif
+#ifdef LVE_EXPAND_NEON
+        case Kernel::NEON: function = expandNEON; break;
+#endif
+        default: function = expandScalar; break;
+    }
+}
+
+void SierpinskiExpander::expand(const SierpinskiSoA &parents, SierpinskiSoA &children, size_t begin, size_t end) const {
+    assert(begin <= end && end <= parents.size() && "invalid parent range");
+    function(parents, children, begin, end);
+}
+
+void SierpinskiExpander::toVertices(const SierpinskiSoA &level, size_t begin, size_t end, LveModel::Vertex *out) {
+    for (size_t i = begin; i < end; i++) {
+        out[0].position = {level.topX[i], level.topY[i]};
+        out[1].position = {level.rightX[i], level.rightY[i]};
+        out[2].position = {level.leftX[i], level.leftY[i]};
+        out += 3;
+    }
+}
+
+} // namespace lve
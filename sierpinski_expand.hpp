@@ -0,0 +1,58 @@
+#pragma once
+
+#include "lve_model.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace lve {
+
+// One Sierpinski level in structure-of-arrays form: a separate float array per corner coordinate,
+// so the same coordinate of neighbouring triangles sits next to each other in memory.
+struct SierpinskiSoA {
+    std::vector<float> topX, topY;
+    std::vector<float> rightX, rightY;
+    std::vector<float> leftX, leftY;
+
+    size_t size() const { return topX.size(); }
+    void resize(size_t count);
+};
+
+// Expands level k into level k + 1. This is a pure map: triangle (top, right, left) becomes
+//   child 0 = (top, topRight, topLeft)
+//   child 1 = (topRight, right, rightLeft)
+//   child 2 = (topLeft, rightLeft, left)
+// For a level with n triangles, child c of triangle i is stored at c * n + i. Every child plane
+// is a contiguous run of n triangles, which lets the kernel use plain vector loads and stores.
+// (Read as base-3 digits that is the least significant digit first, the opposite of
+// SierpinskiLevel; both describe the same set of triangles.)
+// The widest kernel the CPU supports is picked at runtime: AVX2 or SSE on x86-64, NEON on
+// arm64, plain C++ everywhere else.
+class SierpinskiExpander {
+public:
+    enum class Kernel { Best, Scalar, SSE, AVX2, NEON };
+
+    explicit SierpinskiExpander(Kernel kernel = Kernel::Best);
+
+    static bool isSupported(Kernel kernel);
+    static const char *kernelName(Kernel kernel);
+    Kernel kernel() const { return selectedKernel; }
+
+    // children must already be sized to 3 * parents.size(); only parents [begin, end) are expanded,
+    // so disjoint ranges can run on different threads
+    void expand(const SierpinskiSoA &parents, SierpinskiSoA &children, size_t begin, size_t end) const;
+    void expand(const SierpinskiSoA &parents, SierpinskiSoA &children) const {
+        expand(parents, children, 0, parents.size());
+    }
+
+    // converts triangles [begin, end) to LveModel vertices (top, right, left), out points at triangle `begin`
+    static void toVertices(const SierpinskiSoA &level, size_t begin, size_t end, LveModel::Vertex *out);
+
+    using KernelFunction = void (*)(const SierpinskiSoA &, SierpinskiSoA &, size_t, size_t);
+
+private:
+    Kernel selectedKernel;
+    KernelFunction function;
+};
+
+} // namespace lve
@@ -0,0 +1,163 @@
+#include "sierpinski_generator.hpp"
+#include "sierpinski_lattice.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace lve {
+
+SierpinskiGenerator::SierpinskiGenerator(LveThreadPool &pool) : pool{pool} {}
+
+uint64_t SierpinskiGenerator::triangleCount(int level) {
+    uint64_t count = 1;
+    for (int i = 0; i < level; i++) {
+        count *= 3;
+    }
+    return count;
+}
+
+std::vector<std::vector<LveModel::Vertex>> SierpinskiGenerator::generate(int levelCount, const Triangle &root) {
+    assert(levelCount > 0 && "Sierpinski triangle needs at least one level");
+
+    std::vector<std::vector<LveModel::Vertex>> vertices(levelCount);
+    levelData.resize(levelCount);
+    for (int level = 0; level < levelCount; level++) {
+        vertices[level].resize(3 * triangleCount(level));
+        levelData[level] = vertices[level].data();
+    }
+    this->levelCount = levelCount;
+
+    // aim for ~16 subtrees per thread so stealing can even out the load,
+    // there is no point in splitting further since every subtree is the same size
+    uint64_t wantedTasks = 16ull * pool.threadCount();
+    splitLevel = 0;
+    while (splitLevel < levelCount - 1 && triangleCount(splitLevel) < wantedTasks) {
+        splitLevel++;
+    }
+
+    LveThreadPool::TaskGroup taskGroup;
+    group = &taskGroup;
+    pool.submit(taskGroup, [this, root] { subdivideTask(0, 0, root); });
+    pool.wait(taskGroup);
+    group = nullptr;
+
+    return vertices;
+}
+
+std::vector<std::vector<LveModel::Vertex>> SierpinskiGenerator::generateExpanded(int levelCount, const Triangle &root) {
+    assert(levelCount > 0 && "Sierpinski triangle needs at least one level");
+    // big enough to amortise a task, small enough to give every thread several chunks of a deep level
+    constexpr size_t CHUNK_SIZE = 16384;
+
+    std::vector<std::vector<LveModel::Vertex>> vertices(levelCount);
+    SierpinskiSoA current;
+    SierpinskiSoA next;
+    current.resize(1);
+    current.topX[0] = root.top.x;
+    current.topY[0] = root.top.y;
+    current.rightX[0] = root.right.x;
+    current.rightY[0] = root.right.y;
+    current.leftX[0] = root.left.x;
+    current.leftY[0] = root.left.y;
+
+    for (int level = 0; level < levelCount; level++) {
+        size_t count = current.size();
+        bool hasNext = level + 1 < levelCount;
+        vertices[level].resize(3 * count);
+        if (hasNext) {
+            next.resize(3 * count);
+        }
+
+        LveThreadPool::TaskGroup taskGroup;
+        for (size_t begin = 0; begin < count; begin += CHUNK_SIZE) {
+            size_t end = std::min(count, begin + CHUNK_SIZE);
+            pool.submit(taskGroup, [&, begin, end] {
+                if (hasNext) {
+                    expander.expand(current, next, begin, end);
+                }
+                SierpinskiExpander::toVertices(current, begin, end, vertices[level].data() + 3 * begin);
+            });
+        }
+        pool.wait(taskGroup);
+        std::swap(current, next);
+    }
+    return vertices;
+}
+
+std::vector<SierpinskiGenerator::IndexedLevel> SierpinskiGenerator::generateIndexed(int levelCount, const Triangle &root) {
+    assert(levelCount > 0 && "Sierpinski triangle needs at least one level");
+    constexpr uint64_t CHUNK_SIZE = 16384;
+
+    std::vector<IndexedLevel> levels(levelCount);
+    for (int level = 0; level < levelCount; level++) {
+        SierpinskiLattice lattice{level, pool};
+        IndexedLevel &out = levels[level];
+        out.vertices.resize(lattice.vertexCount());
+        uint64_t count = triangleCount(level);
+        out.indices.resize(3 * count);
+
+        LveThreadPool::TaskGroup taskGroup;
+        // rows of roughly CHUNK_SIZE corners each
+        uint32_t rowsPerTask = std::max<uint32_t>(1, static_cast<uint32_t>(CHUNK_SIZE >> level));
+        for (uint32_t beginRow = 0; beginRow < lattice.rowCount(); beginRow += rowsPerTask) {
+            uint32_t endRow = std::min(lattice.rowCount(), beginRow + rowsPerTask);
+            pool.submit(taskGroup, [&lattice, &out, &root, beginRow, endRow] {
+                lattice.writeVertices(beginRow, endRow, out.vertices.data() + lattice.rowVertexIndex(beginRow), root);
+            });
+        }
+        for (uint64_t begin = 0; begin < count; begin += CHUNK_SIZE) {
+            uint64_t end = std::min(count, begin + CHUNK_SIZE);
+            pool.submit(taskGroup, [&lattice, &out, begin, end] {
+                lattice.writeIndices(begin, end, out.indices.data() + 3 * begin);
+            });
+        }
+        pool.wait(taskGroup);
+    }
+    return levels;
+}
+
+void SierpinskiGenerator::subdivideTask(int level, uint64_t index, Triangle triangle) {
+    if (level >= splitLevel) {
+        subdivideSerial(level, index, triangle);
+        return;
+    }
+    writeTriangle(level, index, triangle);
+
+    auto topRight = 0.5f * (triangle.top + triangle.right);
+    auto rightLeft = 0.5f * (triangle.right + triangle.left);
+    auto topLeft = 0.5f * (triangle.top + triangle.left);
+    Triangle children[3] = {
+        {triangle.top, topRight, topLeft},
+        {topRight, triangle.right, rightLeft},
+        {topLeft, rightLeft, triangle.left}};
+
+    // hand two children to the pool and keep the third one on this thread
+    for (uint64_t child = 0; child < 2; child++) {
+        pool.submit(*group, [this, level, index, child, t = children[child]] {
+            subdivideTask(level + 1, 3 * index + child, t);
+        });
+    }
+    subdivideTask(level + 1, 3 * index + 2, children[2]);
+}
+
+void SierpinskiGenerator::subdivideSerial(int level, uint64_t index, const Triangle &triangle) {
+    writeTriangle(level, index, triangle);
+    if (level + 1 >= levelCount) {
+        return;
+    }
+    auto topRight = 0.5f * (triangle.top + triangle.right);
+    auto rightLeft = 0.5f * (triangle.right + triangle.left);
+    auto topLeft = 0.5f * (triangle.top + triangle.left);
+    subdivideSerial(level + 1, 3 * index + 0, {triangle.top, topRight, topLeft});
+    subdivideSerial(level + 1, 3 * index + 1, {topRight, triangle.right, rightLeft});
+    subdivideSerial(level + 1, 3 * index + 2, {topLeft, rightLeft, triangle.left});
+}
+
+void SierpinskiGenerator::writeTriangle(int level, uint64_t index, const Triangle &triangle) {
+    LveModel::Vertex *out = levelData[level] + 3 * index;
+    out[0].position = triangle.top;
+    out[1].position = triangle.right;
+    out[2].position = triangle.left;
+}
+
+} // namespace lve
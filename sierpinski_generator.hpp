@@ -0,0 +1,64 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_thread_pool.hpp"
+#include "sierpinski_expand.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// Builds every level of the Sierpinski triangle on a work-stealing pool.
+// Level k has exactly 3^k triangles, so every level is allocated once up front and each task
+// writes into its own slice: the children of triangle i at level k are the triangles 3i, 3i + 1
+// and 3i + 2 at level k + 1, which means a whole subtree owns one contiguous range per level
+// and no two tasks ever touch the same vertices.
+class SierpinskiGenerator {
+public:
+    struct Triangle {
+        glm::vec2 top;
+        glm::vec2 right;
+        glm::vec2 left;
+    };
+
+    // one level as unique corners plus three indices per triangle
+    struct IndexedLevel {
+        std::vector<LveModel::Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    explicit SierpinskiGenerator(LveThreadPool &pool);
+
+    // the full-screen triangle FirstApp has always drawn as level 0
+    static Triangle rootTriangle() { return {{0.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}}; }
+    static uint64_t triangleCount(int level);
+
+    // returns levels 0 .. levelCount - 1, three vertices (top, right, left) per triangle
+    std::vector<std::vector<LveModel::Vertex>> generate(int levelCount, const Triangle &root = rootTriangle());
+
+    // Same levels built breadth first: every level is expanded from the previous one with the
+    // SIMD SierpinskiExpander, split into chunks on the pool. Triangles within a level come out in
+    // the expander's order (child c of triangle i at c * n + i) instead of the order of generate().
+    std::vector<std::vector<LveModel::Vertex>> generateExpanded(int levelCount, const Triangle &root = rootTriangle());
+
+    // Same levels with every corner stored once: neighbouring sub-triangles share their corners, so a
+    // level has (3^(k + 1) + 3) / 2 vertices instead of 3^(k + 1). Shared corners are found through
+    // SierpinskiLattice, no hashing. Triangles come in the order of generate().
+    std::vector<IndexedLevel> generateIndexed(int levelCount, const Triangle &root = rootTriangle());
+
+private:
+    void subdivideTask(int level, uint64_t index, Triangle triangle);
+    void subdivideSerial(int level, uint64_t index, const Triangle &triangle);
+    void writeTriangle(int level, uint64_t index, const Triangle &triangle);
+
+    LveThreadPool &pool;
+    SierpinskiExpander expander{};
+    LveThreadPool::TaskGroup *group = nullptr;
+    std::vector<LveModel::Vertex *> levelData;
+    int levelCount = 0;
+    // levels above this one are split into pool tasks, below it a task walks its subtree alone
+    int splitLevel = 0;
+};
+
+} // namespace lve
@@ -0,0 +1,170 @@
+#include "sierpinski_lattice.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace lve {
+
+namespace {
+
+int popcount(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+#endif
+}
+
+} // namespace
+
+SierpinskiLattice::SierpinskiLattice(int depth, LveThreadPool &pool) : latticeDepth{depth} {
+    // a and b have to fit in 32 bits and so does the number of corners
+    if (depth < 0 || cornerCount(depth) > UINT32_MAX) {
+        throw std::runtime_error("sierpinski lattice: depth " + std::to_string(depth) + " is out of range");
+    }
+    // rows are chunked so every task fills about this many words
+    constexpr size_t WORDS_PER_TASK = 8192;
+
+    side = 1u << depth;
+    rowWords.resize(side + 2);
+    rowWords[0] = 0;
+    for (uint32_t b = 0; b <= side; b++) {
+        uint32_t points = side - b + 1;
+        rowWords[b + 1] = rowWords[b] + (points + 63) / 64;
+    }
+    bits.assign(rowWords[side + 1], 0);
+    wordCorners.resize(bits.size());
+    rowCorners.resize(side + 2);
+
+    // every row only reads the existence rule and writes its own words
+    auto fillRows = [this](uint32_t beginRow, uint32_t endRow) {
+        for (uint32_t b = beginRow; b < endRow; b++) {
+            uint32_t points = side - b + 1;
+            uint32_t count = 0;
+            for (size_t word = 0; word * 64 < points; word++) {
+                uint64_t value = 0;
+                uint32_t end = std::min<uint32_t>(points, static_cast<uint32_t>(word * 64 + 64));
+                for (uint32_t a = static_cast<uint32_t>(word * 64); a < end; a++) {
+                    if (hasTriangle(a, b, side) || hasTriangle(int64_t{a} - 1, b, side) ||
+                        hasTriangle(a, int64_t{b} - 1, side)) {
+                        value |= uint64_t{1} << (a % 64);
+                    }
+                }
+                bits[rowWords[b] + word] = value;
+                wordCorners[rowWords[b] + word] = count;
+                count += popcount(value);
+            }
+            // the row's total for now, turned into a prefix below
+            rowCorners[b + 1] = count;
+        }
+    };
+
+    LveThreadPool::TaskGroup group;
+    uint32_t beginRow = 0;
+    while (beginRow <= side) {
+        uint32_t endRow = beginRow;
+        while (endRow <= side && rowWords[endRow] - rowWords[beginRow] < WORDS_PER_TASK) {
+            endRow++;
+        }
+        pool.submit(group, [fillRows, beginRow, endRow] { fillRows(beginRow, endRow); });
+        beginRow = endRow;
+    }
+    pool.wait(group);
+
+    rowCorners[0] = 0;
+    for (uint32_t b = 0; b <= side; b++) {
+        rowCorners[b + 1] += rowCorners[b];
+    }
+    totalCorners = rowCorners[side + 1];
+    assert(totalCorners == cornerCount(depth) && "lattice corner count doesn't match the closed form");
+}
+
+uint64_t SierpinskiLattice::cornerCount(int depth) {
+    return (3 * SierpinskiGenerator::triangleCount(depth) + 3) / 2;
+}
+
+SierpinskiLattice::Point SierpinskiLattice::leftCorner(int depth, uint64_t index) {
+    assert(index < SierpinskiGenerator::triangleCount(depth) && "triangle index out of range for this level");
+    // least significant digit first, its place value is 1
+    Point point{0, 0};
+    for (int j = 0; j < depth; j++) {
+        uint32_t digit = static_cast<uint32_t>(index % 3);
+        index /= 3;
+        if (digit == 0) {
+            point.b |= 1u << j;
+        } else if (digit == 1) {
+            point.a |= 1u << j;
+        }
+    }
+    return point;
+}
+
+bool SierpinskiLattice::hasTriangle(int64_t a, int64_t b, int64_t side) {
+    return a >= 0 && b >= 0 && a + b < side && (a & b) == 0;
+}
+
+bool SierpinskiLattice::isCorner(uint32_t a, uint32_t b) const {
+    if (b > side || a > side - b) {
+        return false;
+    }
+    return (bits[wordIndex(a, b)] >> (a % 64)) & 1;
+}
+
+uint32_t SierpinskiLattice::vertexIndex(uint32_t a, uint32_t b) const {
+    assert(isCorner(a, b) && "lattice point is not a corner of this level");
+    size_t word = wordIndex(a, b);
+    uint64_t below = bits[word] & ((uint64_t{1} << (a % 64)) - 1);
+    return rowCorners[b] + wordCorners[word] + popcount(below);
+}
+
+void SierpinskiLattice::writeVertices(uint32_t beginRow, uint32_t endRow, LveModel::Vertex *out, const Triangle &root) const {
+    assert(beginRow <= endRow && endRow <= rowCount() && "invalid row range");
+    // dyadic steps, so the corners are bit-identical to the ones found by halving midpoints
+    const glm::vec2 stepA = std::ldexp(1.0f, -latticeDepth) * (root.right - root.left);
+    const glm::vec2 stepB = std::ldexp(1.0f, -latticeDepth) * (root.top - root.left);
+    for (uint32_t b = beginRow; b < endRow; b++) {
+        uint32_t points = side - b + 1;
+        for (size_t word = 0; word * 64 < points; word++) {
+            for (uint64_t value = bits[rowWords[b] + word]; value != 0; value &= value - 1) {
+                uint32_t a = static_cast<uint32_t>(word * 64) + popcount((value & (~value + 1)) - 1);
+                out->position = root.left + static_cast<float>(a) * stepA + static_cast<float>(b) * stepB;
+                out->color = {};
+                out++;
+            }
+        }
+    }
+}
+
+void SierpinskiLattice::writeIndices(uint64_t begin, uint64_t end, uint32_t *out) const {
+    assert(begin <= end && end <= SierpinskiGenerator::triangleCount(latticeDepth) && "invalid triangle range");
+    // siblings only differ in their last digit, so the corner of the parent is decoded once per
+    // group of three (top child: b + 1, right child: a + 1, left child: the parent's corner)
+    uint64_t index = begin;
+    while (index < end) {
+        Point parent = latticeDepth > 0 ? leftCorner(latticeDepth - 1, index / 3) : Point{0, 0};
+        parent.a <<= 1;
+        parent.b <<= 1;
+        uint64_t groupEnd = latticeDepth > 0 ? index - index % 3 + 3 : end;
+        for (; index < end && index < groupEnd; index++) {
+            Point corner = parent;
+            if (latticeDepth > 0 && index % 3 == 0) {
+                corner.b += 1;
+            } else if (latticeDepth > 0 && index % 3 == 1) {
+                corner.a += 1;
+            }
+            out[0] = vertexIndex(corner.a, corner.b + 1);
+            out[1] = vertexIndex(corner.a + 1, corner.b);
+            out[2] = vertexIndex(corner.a, corner.b);
+            out += 3;
+        }
+    }
+}
+
+} // namespace lve
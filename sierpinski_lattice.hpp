@@ -0,0 +1,74 @@
+#pragma once
+
+#include "lve_model.hpp"
+#include "lve_thread_pool.hpp"
+#include "sierpinski_generator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lve {
+
+// The corners of one Sierpinski level as points of a triangular lattice, so shared corners can be
+// found without hashing positions.
+// With n = 2^depth, lattice point (a, b) is root.left + a / n * (right - left) + b / n * (top - left),
+// 0 <= a + b <= n. Triangle i of the level (SierpinskiLevel's digit order) has its left corner at
+// (a, b), its right corner at (a + 1, b) and its top at (a, b + 1), where every top digit adds
+// its place value 2^(depth - j) to b and every right digit adds it to a. So a & b == 0 exactly
+// for the triangles that exist, and a point is a corner when one of the three triangles it can
+// belong to exists. That needs no walk over the triangles, every row is filled on its own.
+// Corners are numbered in row order (b, then a): one bit per lattice point plus a running count
+// per 64 bit word turns a point into its vertex index with a single popcount.
+// Memory is n^2 / 16 bytes for the bits plus half that for the counts, 6 MiB at depth 13.
+class SierpinskiLattice {
+public:
+    using Triangle = SierpinskiGenerator::Triangle;
+
+    struct Point {
+        uint32_t a;
+        uint32_t b;
+    };
+
+    // fills the bits and counts of level `depth`, rows are split over the pool
+    SierpinskiLattice(int depth, LveThreadPool &pool);
+
+    // (3^(depth + 1) + 3) / 2, every triangle has three corners and all but the outer three are shared
+    static uint64_t cornerCount(int depth);
+    // left corner of triangle `index` at level `depth`
+    static Point leftCorner(int depth, uint64_t index);
+
+    int depth() const { return latticeDepth; }
+    uint32_t vertexCount() const { return totalCorners; }
+    uint32_t rowCount() const { return side + 1; }
+
+    bool isCorner(uint32_t a, uint32_t b) const;
+    // vertex index of corner (a, b), which has to be a corner
+    uint32_t vertexIndex(uint32_t a, uint32_t b) const;
+
+    // writes the corners of rows [beginRow, endRow) to out, which points at vertex vertexIndex of
+    // the first corner in beginRow; disjoint row ranges can be written from different threads
+    void writeVertices(uint32_t beginRow, uint32_t endRow, LveModel::Vertex *out, const Triangle &root) const;
+    // three vertex indices (top, right, left) for triangles [begin, end), the same order and winding
+    // as the vertices of SierpinskiLevel::generateRange
+    void writeIndices(uint64_t begin, uint64_t end, uint32_t *out) const;
+    // vertex index of the first corner in row b
+    uint32_t rowVertexIndex(uint32_t b) const { return rowCorners[b]; }
+
+private:
+    static bool hasTriangle(int64_t a, int64_t b, int64_t side);
+    size_t wordIndex(uint32_t a, uint32_t b) const { return rowWords[b] + a / 64; }
+
+    int latticeDepth;
+    uint32_t side;
+    uint32_t totalCorners = 0;
+    // row b starts at word rowWords[b] and has side - b + 1 points
+    std::vector<size_t> rowWords;
+    std::vector<uint64_t> bits;
+    // corners before this word within its row
+    std::vector<uint32_t> wordCorners;
+    // corners before this row
+    std::vector<uint32_t> rowCorners;
+};
+
+} // namespace lve
@@ -0,0 +1,79 @@
+#include "sierpinski_level.hpp"
+
+#include <cassert>
+#include <cmath>
+
+namespace lve {
+
+// Picking corner c halves the triangle towards that corner:
+//   child = 0.5 * parent + 0.5 * parentCorner[c]
+// Unrolling this from the root gives, for the digits d_1 .. d_k of the index,
+//   triangle = 2^-k * root + sum_j 2^-j * rootCorner[d_j]
+// All the terms are dyadic, so the result is bit-identical to halving midpoints recursively.
+glm::vec2 SierpinskiLevel::offset(int depth, uint64_t index, const Triangle &root) {
+    assert(index < triangleCount(depth) && "triangle index out of range for this level");
+    const glm::vec2 corners[3] = {root.top, root.right, root.left};
+
+    glm::vec2 result{0.0f, 0.0f};
+    // least significant digit first, it is the last (smallest) step on the way down
+    float scale = std::ldexp(1.0f, -depth);
+    for (int j = depth; j > 0; j--) {
+        result += scale * corners[index % 3];
+        index /= 3;
+        scale *= 2.0f;
+    }
+    return result;
+}
+
+SierpinskiLevel::Triangle SierpinskiLevel::triangle(int depth, uint64_t index, const Triangle &root) {
+    glm::vec2 translation = offset(depth, index, root);
+    float scale = std::ldexp(1.0f, -depth);
+    return {scale * root.top + translation, scale * root.right + translation, scale * root.left + translation};
+}
+
+void SierpinskiLevel::generateOffsets(int depth, uint64_t begin, uint64_t end, glm::vec2 *out, const Triangle &root) {
+    assert(begin <= end && end <= triangleCount(depth) && "invalid triangle range");
+    const glm::vec2 corners[3] = {root.top, root.right, root.left};
+    const float scale = std::ldexp(1.0f, -depth);
+
+    uint64_t index = begin;
+    while (index < end) {
+        if (depth == 0) {
+            *out++ = {0.0f, 0.0f};
+            index++;
+            continue;
+        }
+        glm::vec2 parentOffset = offset(depth - 1, index / 3, root);
+        uint64_t groupEnd = index - index % 3 + 3;
+        for (; index < end && index < groupEnd; index++) {
+            *out++ = parentOffset + scale * corners[index % 3];
+        }
+    }
+}
+
+void SierpinskiLevel::generateRange(int depth, uint64_t begin, uint64_t end, LveModel::Vertex *out, const Triangle &root) {
+    assert(begin <= end && end <= triangleCount(depth) && "invalid triangle range");
+    if (begin == end) {
+        return;
+    }
+    const glm::vec2 corners[3] = {root.top, root.right, root.left};
+    const float scale = std::ldexp(1.0f, -depth);
+    const glm::vec2 scaled[3] = {scale * root.top, scale * root.right, scale * root.left};
+
+    // siblings only differ in their last digit, so the offset of the parent is computed once
+    // per group of three and the last step is added on top of it
+    uint64_t index = begin;
+    while (index < end) {
+        glm::vec2 parentOffset = depth > 0 ? offset(depth - 1, index / 3, root) : glm::vec2{0.0f, 0.0f};
+        uint64_t groupEnd = depth > 0 ? index - index % 3 + 3 : end;
+        for (; index < end && index < groupEnd; index++) {
+            glm::vec2 translation = depth > 0 ? parentOffset + scale * corners[index % 3] : parentOffset;
+            out[0].position = scaled[0] + translation;
+            out[1].position = scaled[1] + translation;
+            out[2].position = scaled[2] + translation;
+            out += 3;
+        }
+    }
+}
+
+} // namespace lve
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "sierpinski_generator.hpp"
+
+#include <cstdint>
+
+namespace lve {
+
+// Direct, index-addressable access to one level of the Sierpinski triangle.
+// Read the index i of a triangle at depth k as k base-3 digits, most significant first:
+// every digit picks the corner sub-triangle (0 = top, 1 = right, 2 = left) taken on the way
+// down from the root. That is the same order SierpinskiGenerator writes its levels in, so
+// both produce identical buffers, but here any triangle costs O(k) with no recursion and no
+// stack, and any sub-range of a level can be (re)generated on its own.
+// Neighbouring indices are neighbouring on screen, so a visible region of a deep level is
+// a handful of contiguous index ranges.
+class SierpinskiLevel {
+public:
+    using Triangle = SierpinskiGenerator::Triangle;
+
+    static uint64_t triangleCount(int depth) { return SierpinskiGenerator::triangleCount(depth); }
+
+    // vertices of triangle `index` at level `depth`
+    static Triangle triangle(int depth, uint64_t index, const Triangle &root = SierpinskiGenerator::rootTriangle());
+
+    // writes triangles [begin, end) of level `depth` to out, three vertices (top, right, left) per triangle,
+    // out must have room for 3 * (end - begin) vertices
+    static void generateRange(
+        int depth,
+        uint64_t begin,
+        uint64_t end,
+        LveModel::Vertex *out,
+        const Triangle &root = SierpinskiGenerator::rootTriangle());
+
+    // translation of triangle `index` relative to the root triangle scaled by 2^-depth,
+    // every triangle of a level is that one scaled triangle moved by this offset
+    static glm::vec2 offset(int depth, uint64_t index, const Triangle &root = SierpinskiGenerator::rootTriangle());
+
+    // offsets of triangles [begin, end) of level `depth`, one per triangle
+    static void generateOffsets(
+        int depth,
+        uint64_t begin,
+        uint64_t end,
+        glm::vec2 *out,
+        const Triangle &root = SierpinskiGenerator::rootTriangle());
+};
+
+} // namespace lve
@@ -1,30 +1,60 @@
 #include "simple_render_system.hpp"
+#include "shaders/instanced_shader.vert.hpp"
+#include "shaders/packed_shader.vert.hpp"
+#include "shaders/procedural_shader.vert.hpp"
+#include "shaders/simple_shader.frag.hpp"
+#include "shaders/simple_shader.vert.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 struct SimplePushConstantData{
     glm::mat2 transform{1.f};
     glm::vec2 offset;
     alignas(16) glm::vec3 color;
     float alpha;
+    // only read by the procedural vertex shader
+    int level;
 };
 
 
 namespace lve {
 
-SimpleRenderSystem::SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass) : lveDevice{device} {
+SimpleRenderSystem::SimpleRenderSystem(
+    LveDevice& device,
+    VkRenderPass renderPass,
+    RenderMode renderMode,
+    int maxDepth,
+    LvePipelineBuilder* builder,
+    VertexFormat vertexFormat)
+    : lveDevice{device},
+      renderMode{renderMode},
+      maxDepth{maxDepth},
+      renderPass{renderPass},
+      vertexFormat{renderMode == RenderMode::Vertices ? vertexFormat : VertexFormat::Float},
+      pipelines{[this](const Variant& variant) { return createPipeline(variant); }, builder} {
     
     createPipelineLayout();
-    createPipeline(renderPass);
+    if (builder) {
+        fallbackPipeline = &pipelines.get(fallbackVariant());
+    }
+    // both variants are used every second while a level fades in, start them up front instead of mid frame
+    // (without a builder this compiles them right here)
+    pipelines.tryGet(variant(false));
+    pipelines.tryGet(variant(true));
 }
 
 SimpleRenderSystem::~SimpleRenderSystem() {
+    // background builds still use the layout
+    pipelines.wait();
     vkDestroyPipelineLayout(lveDevice.device(), pipelineLayout, nullptr);
 }
 
@@ -51,34 +81,134 @@ void SimpleRenderSystem::createPipelineLayout() {
 }
 
 
-void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
+SimpleRenderSystem::Variant SimpleRenderSystem::variant(bool blended) const {
+    int maxLevel = renderMode == RenderMode::Procedural ? std::min(maxDepth - 1, MAX_PROCEDURAL_DEPTH) : 0;
+    return {renderMode, blended, maxLevel, vertexFormat};
+}
+
+SimpleRenderSystem::Variant SimpleRenderSystem::fallbackVariant() const {
+    return {renderMode, true, renderMode == RenderMode::Procedural ? MAX_PROCEDURAL_DEPTH : 0, vertexFormat};
+}
+
+std::unique_ptr<LvePipeline> SimpleRenderSystem::createPipeline(const Variant& variant) {
     assert(pipelineLayout != nullptr && "cannot create pipeline before pipeline layout");
     PipelineConfigInfo pipelineConfig{};
     LvePipeline::defaultPipelineConfigInfo(pipelineConfig);
     pipelineConfig.renderPass = renderPass;
     pipelineConfig.pipelineLayout = pipelineLayout;
 
-    lvePipeline = std::make_unique<LvePipeline>(
+    // simple_shader.frag: constant_id 0 = BLENDED
+    pipelineConfig.colorBlendAttachment.blendEnable = variant.blended ? VK_TRUE : VK_FALSE;
+    pipelineConfig.fragSpecialization.set(0, variant.blended);
+
+    SpirvSpan vertCode = shaders::simple_shader_vert;
+    if (variant.renderMode == RenderMode::Instanced) {
+        // binding 1 advances per instance and carries the sub-triangle offset
+        pipelineConfig.bindingDescriptions = LveModel::Instance::getBindingDescription();
+        pipelineConfig.attributeDescriptions = LveModel::Instance::getAttributeDescription();
+        vertCode = shaders::instanced_shader_vert;
+    } else if (variant.renderMode == RenderMode::Procedural) {
+        // empty vertex input state, nothing is bound
+        pipelineConfig.bindingDescriptions.clear();
+        pipelineConfig.attributeDescriptions.clear();
+        vertCode = shaders::procedural_shader_vert;
+        // procedural_shader.vert: constant_id 0 = MAX_LEVEL
+        pipelineConfig.vertSpecialization.set(0, static_cast<int32_t>(variant.maxLevel));
+    } else if (variant.vertexFormat != VertexFormat::Float) {
+        // positions only, as ivec2 in fixed point
+        pipelineConfig.bindingDescriptions = LveModel::getBindingDescription(variant.vertexFormat);
+        pipelineConfig.attributeDescriptions = LveModel::getAttributeDescription(variant.vertexFormat);
+        vertCode = shaders::packed_shader_vert;
+        // packed_shader.vert: constant_id 0 = POSITION_SCALE
+        pipelineConfig.vertSpecialization.set(0, LveModel::positionScale(variant.vertexFormat));
+    }
+
+    return std::make_unique<LvePipeline>(
         lveDevice,
-        "shaders/simple_shader.vert.spv",
-        "shaders/simple_shader.frag.spv",
+        vertCode,
+        shaders::simple_shader_frag,
         pipelineConfig);
 }
 
 
-void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects){
-    lvePipeline->bind(commandBuffer);
-    for(auto &obj: gameObjects){
+void SimpleRenderSystem::renderGameObjects(
+    VkCommandBuffer commandBuffer, std::vector<LveGameObject>& gameObjects, LveGpuProfiler* profiler){
+    resolvePipelines(gameObjects);
+    recordDraws(commandBuffer, gameObjects, 0, gameObjects.size(), profiler);
+}
+
+void SimpleRenderSystem::renderGameObjects(
+    VkCommandBuffer primaryCommandBuffer,
+    std::vector<LveGameObject>& gameObjects,
+    LveRenderer& renderer,
+    LveParallelRecorder& recorder){
+    resolvePipelines(gameObjects);
+    recorder.record(renderer, primaryCommandBuffer, gameObjects.size(), [&](VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+        recordDraws(commandBuffer, gameObjects, begin, end, nullptr);
+    });
+}
+
+void SimpleRenderSystem::resolvePipelines(const std::vector<LveGameObject>& gameObjects){
+    drawPipelines.resize(gameObjects.size());
+    for (size_t i = 0; i < gameObjects.size(); i++) {
+        LvePipeline* pipeline = pipelines.tryGet(variant(gameObjects[i].alpha < 1.0f));
+        if (pipeline == nullptr) {
+            // still compiling
+            pipeline = fallbackPipeline;
+        }
+        drawPipelines[i] = pipeline;
+    }
+}
+
+void SimpleRenderSystem::recordDraws(
+    VkCommandBuffer commandBuffer,
+    const std::vector<LveGameObject>& gameObjects,
+    size_t begin,
+    size_t end,
+    LveGpuProfiler* profiler) const{
+    LvePipeline* boundPipeline = nullptr;
+    const LveMeshArena* boundArena = nullptr;
+    for(size_t i = begin; i < end; i++){
+        const auto &obj = gameObjects[i];
+        // objects come in depth order and only the fading one is blended, so this rebinds at most twice
+        LvePipeline* pipeline = drawPipelines[i];
+        if (pipeline != boundPipeline) {
+            pipeline->bind(commandBuffer);
+            boundPipeline = pipeline;
+        }
         //obj.transform2d.rotation = glm::mod(obj.transform2d.rotation +0.01f , glm::two_pi<float>());
         SimplePushConstantData push{};
         push.offset = obj.transform2d.translation;
         push.color = obj.color;
         push.transform = obj.transform2d.mat2();
         push.alpha = obj.alpha;
+        push.level = obj.depth;
 
         vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
-        obj.model->bind(commandBuffer);
-        obj.model->draw(commandBuffer);
+        uint32_t scope = profiler ? profiler->beginScope(commandBuffer, "draw depth", obj.depth) : UINT32_MAX;
+        if (renderMode == RenderMode::Procedural) {
+            // 3 vertices for each of the 3^depth sub-triangles
+            assert(obj.depth >= 0 && obj.depth <= MAX_PROCEDURAL_DEPTH && "procedural vertex count must fit in 32 bits");
+            assert(obj.depth < maxDepth && "level is deeper than the pipeline was specialized for");
+            uint32_t vertexCount = 3;
+            for (int level = 0; level < obj.depth; level++) {
+                vertexCount *= 3;
+            }
+            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+        } else if (obj.meshArena) {
+            // all levels share the arena, so it is bound once and every draw picks its range
+            if (obj.meshArena.get() != boundArena) {
+                obj.meshArena->bind(commandBuffer);
+                boundArena = obj.meshArena.get();
+            }
+            obj.meshArena->draw(commandBuffer, obj.mesh);
+        } else {
+            obj.model->bind(commandBuffer);
+            obj.model->draw(commandBuffer);
+        }
+        if (profiler) {
+            profiler->endScope(commandBuffer, scope);
+        }
     }
 }
 
@@ -1,12 +1,16 @@
 #pragma once
 
 #include "lve_device.hpp"
+#include "lve_gpu_profiler.hpp"
+#include "lve_parallel_recorder.hpp"
 #include "lve_pipeline.hpp"
+#include "lve_pipeline_builder.hpp"
 #include "lve_game_object.hpp"
 
 
 
 #include <memory>
+#include <tuple>
 #include <vector>
 
 
@@ -15,23 +19,97 @@
 
 namespace lve {
 
+    enum class RenderMode {
+        // one vertex buffer per level, three vertices per sub-triangle
+        Vertices,
+        // one triangle per level (already scaled to the level) drawn once per sub-triangle offset
+        Instanced,
+        // no vertex buffers, the vertex shader computes every position from gl_VertexIndex
+        Procedural,
+    };
+
     class SimpleRenderSystem {
         public:
-        SimpleRenderSystem(LveDevice& device, VkRenderPass renderPass);
+        // the deepest level the procedural shader can decode, 3 * 3^19 vertices still fit in 32 bits
+        static constexpr int MAX_PROCEDURAL_DEPTH = 19;
+
+        // maxDepth: levels 0 .. maxDepth - 1 are drawn, specialized into the procedural shader.
+        // With a builder only a generic fallback pipeline is compiled right away, the specialized
+        // variants are compiled in the background and replace it once they are ready.
+        // vertexFormat: layout of the models' vertex buffers, only RenderMode::Vertices reads them packed
+        SimpleRenderSystem(
+            LveDevice& device,
+            VkRenderPass renderPass,
+            RenderMode renderMode = RenderMode::Vertices,
+            int maxDepth = MAX_PROCEDURAL_DEPTH + 1,
+            LvePipelineBuilder* builder = nullptr,
+            VertexFormat vertexFormat = VertexFormat::Float);
         ~SimpleRenderSystem();
         SimpleRenderSystem(const SimpleRenderSystem&) = delete;
         SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
-        void renderGameObjects(VkCommandBuffer commandbuffer, std::vector<LveGameObject>& gameObjects);
+        // with a profiler every draw gets its own gpu timing scope, named after the object's depth
+        void renderGameObjects(
+            VkCommandBuffer commandbuffer,
+            std::vector<LveGameObject>& gameObjects,
+            LveGpuProfiler* profiler = nullptr);
+        // same draws, recorded by the recorder's threads into secondary command buffers; the render
+        // pass has to be begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS. No per draw gpu
+        // scopes here, the profiler is only used from one thread
+        void renderGameObjects(
+            VkCommandBuffer primaryCommandBuffer,
+            std::vector<LveGameObject>& gameObjects,
+            LveRenderer& renderer,
+            LveParallelRecorder& recorder);
     
+        // number of pipeline variants built so far
+        size_t variantCount() const { return pipelines.size(); }
+
     private:
+        // everything a pipeline variant is specialized on
+        struct Variant {
+            // vertex fetch: picks the vertex shader and the vertex input state
+            RenderMode renderMode;
+            // off for objects with alpha 1: no blending and a fragment shader writing alpha 1
+            bool blended;
+            // MAX_LEVEL of the procedural shader, 0 for the other modes
+            int maxLevel;
+            // the packed formats use packed_shader.vert, always Float for the other modes
+            VertexFormat vertexFormat;
+
+            bool operator<(const Variant& other) const {
+                return std::tie(renderMode, blended, maxLevel, vertexFormat) <
+                       std::tie(other.renderMode, other.blended, other.maxLevel, other.vertexFormat);
+            }
+        };
 
         void createPipelineLayout();
-        void createPipeline(VkRenderPass renderPass);
+        std::unique_ptr<LvePipeline> createPipeline(const Variant& variant);
+        Variant variant(bool blended) const;
+        // blended and specialized for the deepest level, draws every object correctly, just not as fast
+        Variant fallbackVariant() const;
+        // picks every object's pipeline up front, the variants may only be touched by one thread
+        void resolvePipelines(const std::vector<LveGameObject>& gameObjects);
+        // draws gameObjects[begin, end) with the pipelines resolved for them, safe to call
+        // concurrently for disjoint ranges into different command buffers
+        void recordDraws(
+            VkCommandBuffer commandBuffer,
+            const std::vector<LveGameObject>& gameObjects,
+            size_t begin,
+            size_t end,
+            LveGpuProfiler* profiler) const;
 
         LveDevice &lveDevice;
+        RenderMode renderMode;
+        int maxDepth;
+        VkRenderPass renderPass;
+        VertexFormat vertexFormat;
         
-        std::unique_ptr<LvePipeline>lvePipeline;
         VkPipelineLayout pipelineLayout;
+        LvePipelineVariants<Variant> pipelines;
+        // only with a builder
+        LvePipeline* fallbackPipeline = nullptr;
+        // per object, filled by resolvePipelines
+        std::vector<LvePipeline*> drawPipelines;
     
     };
 }
\ No newline at end of file